@@ -0,0 +1,589 @@
+// Micro-benchmarks for the individual stages of snapDocument().
+//
+// Each stage is timed in isolation on a synthetic photographed page at
+// 12MP, 48MP and 108MP, reporting median and p95 latency plus heap
+// allocations per call.
+//
+// --corpus runs detection over generated scenes with known page corners and
+// compares the success rate and latency of the multi-scale detector with the
+// previous single 600px pass using fixed Canny thresholds, then repeats the
+// comparison on scenes where the page covers only 1-3% of the frame.
+//
+// --memory runs a separate staging -> original -> current simulation over a
+// batch of pages and reports resident set size per page, comparing the old
+// clone-per-copy scheme with shared PageBuffers.
+//
+// Allocation counting replaces the global operator new. cv::Mat buffers come
+// from cv::fastMalloc, but every buffer allocation also heap-allocates its
+// UMatData header through operator new, so Mat allocations are counted too.
+#include "doc_snapper.h"
+#include "doc_snapper_stages.h"
+#include "binarize.h"
+#include "page_buffer.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+namespace {
+std::atomic<size_t> g_allocCount{0};
+
+void *countedAlloc(std::size_t size)
+{
+    g_allocCount.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *countedAlignedAlloc(std::size_t size, std::align_val_t align)
+{
+    g_allocCount.fetch_add(1, std::memory_order_relaxed);
+    void *p = nullptr;
+    const std::size_t alignment = std::max(static_cast<std::size_t>(align), sizeof(void *));
+    if (posix_memalign(&p, alignment, size ? size : 1) != 0)
+        throw std::bad_alloc();
+    return p;
+}
+} // namespace
+
+void *operator new(std::size_t size) { return countedAlloc(size); }
+void *operator new[](std::size_t size) { return countedAlloc(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    try { return countedAlloc(size); } catch (...) { return nullptr; }
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    try { return countedAlloc(size); } catch (...) { return nullptr; }
+}
+void *operator new(std::size_t size, std::align_val_t align) { return countedAlignedAlloc(size, align); }
+void *operator new[](std::size_t size, std::align_val_t align) { return countedAlignedAlloc(size, align); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+namespace {
+
+struct BenchResult {
+    std::string stage;
+    double medianMs{0.0};
+    double p95Ms{0.0};
+    double allocsPerCall{0.0};
+};
+
+struct InputSize {
+    const char *label;
+    int width;
+    int height;
+};
+
+// Run fn `iterations` times (after one warm-up call) and summarise.
+BenchResult runStage(const std::string &stage, int iterations, const std::function<void()> &fn)
+{
+    fn();  // warm-up: page in code and let OpenCV initialise its thread pool
+
+    std::vector<double> samples;
+    samples.reserve(static_cast<size_t>(iterations));
+    size_t allocs = 0;
+    for (int i = 0; i < iterations; ++i) {
+        const size_t allocsBefore = g_allocCount.load(std::memory_order_relaxed);
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const auto end = std::chrono::steady_clock::now();
+        allocs += g_allocCount.load(std::memory_order_relaxed) - allocsBefore;
+        samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    std::sort(samples.begin(), samples.end());
+    BenchResult r;
+    r.stage = stage;
+    r.medianMs = samples[samples.size() / 2];
+    const size_t p95Index = std::min(samples.size() - 1,
+                                     static_cast<size_t>(0.95 * static_cast<double>(samples.size())));
+    r.p95Ms = samples[p95Index];
+    r.allocsPerCall = static_cast<double>(allocs) / iterations;
+    return r;
+}
+
+// Where every buffer and list of a workspace currently keeps its storage
+std::vector<const void *> workspaceStorage(const SnapWorkspace &workspace)
+{
+    std::vector<const void *> storage = {
+        workspace.resizedBuffer.data, workspace.grayBuffer.data, workspace.blurredBuffer.data,
+        workspace.edgedBuffer.data, workspace.coarsePatch.data, workspace.coarsePatchGray.data,
+        workspace.finePatchGray.data, workspace.candidates.data(), workspace.ranked.data(),
+        workspace.approx.data(), workspace.quad.data(), workspace.subPixPoint.data(),
+        workspace.contoursByWidth.data(),
+    };
+    for (const std::vector<std::vector<cv::Point>> &contours : workspace.contoursByWidth) {
+        storage.push_back(contours.data());
+        for (const std::vector<cv::Point> &contour : contours)
+            storage.push_back(contour.data());
+    }
+    return storage;
+}
+
+// Calls of detectDocument() that moved any of the workspace's storage, after
+// one call to let it settle for these options
+int workspaceReallocations(const cv::Mat &image, const DetectionOptions &options,
+                           SnapWorkspace &workspace, int iterations)
+{
+    detectDocument(image, options, workspace);
+    int reallocating = 0;
+    for (int i = 0; i < iterations; ++i) {
+        const std::vector<const void *> before = workspaceStorage(workspace);
+        detectDocument(image, options, workspace);
+        if (workspaceStorage(workspace) != before)
+            ++reallocating;
+    }
+    return reallocating;
+}
+
+// A slightly rotated white page with text-like strokes on a textured desk.
+// A cluttered desk adds hundreds of small objects around the page, which
+// produce thousands of contours at detection resolution.
+cv::Mat makeSyntheticPage(int width, int height, bool cluttered = false)
+{
+    cv::Mat image(height, width, CV_8UC3);
+    // Low-frequency texture, upscaled so generation stays cheap at 108MP
+    cv::Mat noise(height / 16 + 1, width / 16 + 1, CV_8UC3);
+    cv::RNG rng(12345);
+    rng.fill(noise, cv::RNG::UNIFORM, 40, 110);
+    cv::resize(noise, image, image.size(), 0, 0, cv::INTER_LINEAR);
+
+    if (cluttered) {
+        // Sized relative to the detection width so they survive the downscale
+        const int unit = std::max(1, width / kDetectionWidth);
+        for (int i = 0; i < 600; ++i) {
+            const cv::Point center(rng.uniform(0, width), rng.uniform(0, height));
+            const cv::Scalar color(rng.uniform(0, 255), rng.uniform(0, 255), rng.uniform(0, 255));
+            const int size = rng.uniform(2, 14) * unit;
+            switch (i % 3) {
+            case 0:
+                cv::rectangle(image, center, center + cv::Point(size, size / 2 + unit), color, cv::FILLED);
+                break;
+            case 1:
+                cv::circle(image, center, size, color, std::max(1, unit / 2));
+                break;
+            default:
+                cv::line(image, center, center + cv::Point(size * 3, size), color, std::max(1, unit));
+                break;
+            }
+        }
+    }
+
+    const float w = static_cast<float>(width);
+    const float h = static_cast<float>(height);
+    const std::vector<cv::Point> page = {
+        {static_cast<int>(0.18f * w), static_cast<int>(0.12f * h)},
+        {static_cast<int>(0.80f * w), static_cast<int>(0.16f * h)},
+        {static_cast<int>(0.84f * w), static_cast<int>(0.90f * h)},
+        {static_cast<int>(0.14f * w), static_cast<int>(0.86f * h)},
+    };
+    cv::fillConvexPoly(image, page, cv::Scalar(235, 235, 235), cv::LINE_AA);
+
+    const int lineSpacing = std::max(8, height / 60);
+    const int thickness = std::max(1, height / 1000);
+    for (int y = static_cast<int>(0.2f * h); y < static_cast<int>(0.8f * h); y += lineSpacing) {
+        cv::line(image, {static_cast<int>(0.25f * w), y}, {static_cast<int>(0.72f * w), y + lineSpacing / 8},
+                 cv::Scalar(40, 40, 40), thickness, cv::LINE_AA);
+    }
+    return image;
+}
+
+// A 12MP scene with a page of random size, position and perspective whose
+// true corners (TL, TR, BR, BL) are returned in `corners`. The page spans
+// minPageHeight-maxPageHeight of the frame height. Small pages in large
+// frames and cluttered or dim scenes are deliberately common.
+cv::Mat makeLabeledScene(cv::RNG &rng, std::vector<cv::Point2f> &corners,
+                         float minPageHeight = 0.2f, float maxPageHeight = 0.9f)
+{
+    const int width = 4000;
+    const int height = 3000;
+    cv::Mat image(height, width, CV_8UC3);
+    cv::Mat noise(height / 16 + 1, width / 16 + 1, CV_8UC3);
+    const int desk = rng.uniform(20, 120);
+    rng.fill(noise, cv::RNG::UNIFORM, desk, desk + 70);
+    cv::resize(noise, image, image.size(), 0, 0, cv::INTER_LINEAR);
+    if (rng.uniform(0, 2) == 1) {
+        for (int i = 0; i < 300; ++i) {
+            const cv::Point center(rng.uniform(0, width), rng.uniform(0, height));
+            cv::circle(image, center, rng.uniform(10, 80),
+                       cv::Scalar(rng.uniform(0, 255), rng.uniform(0, 255), rng.uniform(0, 255)), 4);
+        }
+    }
+
+    // Each corner is jittered by up to 6% of the page width
+    const float pageHeight = rng.uniform(minPageHeight, maxPageHeight) * height;
+    const float pageWidth = pageHeight / 1.414f;
+    const float cx = rng.uniform(pageWidth * 0.6f, width - pageWidth * 0.6f);
+    const float cy = rng.uniform(pageHeight * 0.6f, height - pageHeight * 0.6f);
+    const float jitter = 0.06f * pageWidth;
+    corners = {
+        {cx - pageWidth / 2 + rng.uniform(-jitter, jitter), cy - pageHeight / 2 + rng.uniform(-jitter, jitter)},
+        {cx + pageWidth / 2 + rng.uniform(-jitter, jitter), cy - pageHeight / 2 + rng.uniform(-jitter, jitter)},
+        {cx + pageWidth / 2 + rng.uniform(-jitter, jitter), cy + pageHeight / 2 + rng.uniform(-jitter, jitter)},
+        {cx - pageWidth / 2 + rng.uniform(-jitter, jitter), cy + pageHeight / 2 + rng.uniform(-jitter, jitter)},
+    };
+    std::vector<cv::Point> page;
+    for (const cv::Point2f &p : corners)
+        page.emplace_back(cvRound(p.x), cvRound(p.y));
+    const int paper = rng.uniform(170, 250);
+    cv::fillConvexPoly(image, page, cv::Scalar(paper, paper, paper), cv::LINE_AA);
+
+    const int lines = 30;
+    for (int i = 2; i < lines - 2; ++i) {
+        const float t = static_cast<float>(i) / lines;
+        const cv::Point2f left = corners[0] + (corners[3] - corners[0]) * t;
+        const cv::Point2f right = corners[1] + (corners[2] - corners[1]) * t;
+        const cv::Point2f inset = (right - left) * 0.1f;
+        cv::line(image, left + inset, right - inset, cv::Scalar(40, 40, 40),
+                 std::max(1, static_cast<int>(pageHeight / 800)), cv::LINE_AA);
+    }
+    return image;
+}
+
+// Detect `scenes` labeled scenes with both detectors and print their rates
+void runCorpus(const char *title, int scenes, uint64_t seed, float minPageHeight, float maxPageHeight)
+{
+    DetectionOptions previous;
+    previous.detectionWidths = {kDetectionWidth};
+    previous.autoCannyThresholds = false;
+    const DetectionOptions multiScale;
+
+    struct Tally {
+        int found{0};
+        int correct{0};
+        std::vector<double> ms;
+    };
+    Tally tallies[2];
+    cv::RNG rng(seed);
+    for (int i = 0; i < scenes; ++i) {
+        std::vector<cv::Point2f> truth;
+        const cv::Mat scene = makeLabeledScene(rng, truth, minPageHeight, maxPageHeight);
+        // A corner more than 1% of the diagonal off counts as a miss
+        const double tolerance = 0.01 * std::hypot(scene.cols, scene.rows);
+        const DetectionOptions *options[2] = {&previous, &multiScale};
+        for (int j = 0; j < 2; ++j) {
+            const auto start = std::chrono::steady_clock::now();
+            const DocumentDetection d = detectDocument(scene, *options[j]);
+            tallies[j].ms.push_back(std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count());
+            if (!d.found)
+                continue;
+            ++tallies[j].found;
+            double worst = 0.0;
+            for (size_t c = 0; c < 4; ++c)
+                worst = std::max(worst, static_cast<double>(cv::norm(d.corners[c] - truth[c])));
+            if (worst <= tolerance)
+                ++tallies[j].correct;
+        }
+    }
+
+    std::printf("%d labeled 12MP scenes, %s\n", scenes, title);
+    std::printf("%-28s %10s %10s %12s %12s\n", "detector", "found", "correct", "median ms", "mean ms");
+    const char *names[2] = {"single 600px, Canny 75/200", "multi-scale, auto Canny"};
+    for (int j = 0; j < 2; ++j) {
+        std::vector<double> &ms = tallies[j].ms;
+        std::sort(ms.begin(), ms.end());
+        double mean = 0.0;
+        for (double v : ms)
+            mean += v;
+        mean /= std::max<size_t>(1, ms.size());
+        std::printf("%-28s %9.1f%% %9.1f%% %12.2f %12.2f\n", names[j],
+                    100.0 * tallies[j].found / scenes, 100.0 * tallies[j].correct / scenes,
+                    ms.empty() ? 0.0 : ms[ms.size() / 2], mean);
+    }
+}
+
+int runCorpusBench(int scenes)
+{
+    runCorpus("page 20-90% of the frame height", scenes, 424242, 0.2f, 0.9f);
+    // Small documents: a receipt or ID card across the room covers 1-3% of
+    // the frame, which the candidate noise cutoff must leave alone
+    std::printf("\n");
+    runCorpus("small page, 1-3% of the frame", std::max(1, scenes / 4), 171717, 0.14f, 0.25f);
+    return 0;
+}
+
+// Current resident set size in bytes, 0 where unsupported
+size_t residentBytes()
+{
+#if defined(__linux__)
+    std::FILE *statm = std::fopen("/proc/self/statm", "r");
+    if (!statm)
+        return 0;
+    unsigned long totalPages = 0;
+    unsigned long residentPages = 0;
+    const int fields = std::fscanf(statm, "%lu %lu", &totalPages, &residentPages);
+    std::fclose(statm);
+    return fields == 2 ? residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE)) : 0;
+#else
+    return 0;
+#endif
+}
+
+// Hold `pages` imported pages the way the GUI does (staged, original and
+// current image per page) and return the RSS growth per page.
+double residentBytesPerPage(int pages, int width, int height, bool shareBuffers)
+{
+    const size_t before = residentBytes();
+    std::vector<PageBuffer> staged, original, current;
+    std::vector<cv::Mat> stagedMats, originalMats, currentMats;
+    for (int i = 0; i < pages; ++i) {
+        const cv::Mat page = makeSyntheticPage(width, height);
+        if (shareBuffers) {
+            staged.emplace_back(page);
+            original.push_back(staged.back());
+            current.push_back(original.back());
+        } else {
+            // Previous scheme: every stage kept its own deep copy
+            stagedMats.push_back(page);
+            originalMats.push_back(page.clone());
+            currentMats.push_back(page.clone());
+        }
+    }
+    const size_t after = residentBytes();
+    return after > before ? static_cast<double>(after - before) / pages : 0.0;
+}
+
+int runMemoryBench(int pages)
+{
+#if defined(__GLIBC__)
+    // Serve every page from its own mapping so freed pages leave the RSS
+    // and the two runs below do not skew each other.
+    mallopt(M_MMAP_THRESHOLD, 128 * 1024);
+#endif
+    const int width = 2000;
+    const int height = 1500;
+    if (residentBytes() == 0) {
+        std::fprintf(stderr, "RSS measurement is not supported on this platform\n");
+        return 1;
+    }
+    const double pageMiB = width * height * 3 / (1024.0 * 1024.0);
+    const double cloned = residentBytesPerPage(pages, width, height, false) / (1024.0 * 1024.0);
+    const double shared = residentBytesPerPage(pages, width, height, true) / (1024.0 * 1024.0);
+    std::printf("%d pages of %dx%d BGR (%.1f MiB of pixels each)\n", pages, width, height, pageMiB);
+    std::printf("%-24s %14s\n", "scheme", "RSS MiB/page");
+    std::printf("%-24s %14.1f\n", "clone per copy", cloned);
+    std::printf("%-24s %14.1f\n", "shared PageBuffer", shared);
+    if (shared > 0.0)
+        std::printf("reduction: %.1fx\n", cloned / shared);
+    return 0;
+}
+
+void printUsage(const char *argv0)
+{
+    std::printf("Usage: %s [--iterations N] [--sizes 12,48,108]\n"
+                "       %s --corpus [SCENES]  (detection success rate, default 200 scenes)\n"
+                "       %s --memory [PAGES]   (RSS per imported page, default 100 pages)\n",
+                argv0, argv0, argv0);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int iterations = 15;
+    std::vector<int> megapixels = {12, 48, 108};
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--iterations" && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--corpus") {
+            int scenes = 200;
+            if (i + 1 < argc && std::atoi(argv[i + 1]) > 0)
+                scenes = std::atoi(argv[++i]);
+            return runCorpusBench(scenes);
+        } else if (arg == "--memory") {
+            int pages = 100;
+            if (i + 1 < argc && std::atoi(argv[i + 1]) > 0)
+                pages = std::atoi(argv[++i]);
+            return runMemoryBench(pages);
+        } else if (arg == "--sizes" && i + 1 < argc) {
+            megapixels.clear();
+            std::string list = argv[++i];
+            size_t pos = 0;
+            while (pos < list.size()) {
+                const size_t comma = list.find(',', pos);
+                megapixels.push_back(std::atoi(list.substr(pos, comma - pos).c_str()));
+                if (comma == std::string::npos)
+                    break;
+                pos = comma + 1;
+            }
+        } else {
+            printUsage(argv[0]);
+            return arg == "-h" || arg == "--help" ? 0 : 2;
+        }
+    }
+
+    // 4:3 frames matching common phone sensors
+    const std::vector<InputSize> allSizes = {
+        {"12MP", 4000, 3000},
+        {"48MP", 8000, 6000},
+        {"108MP", 12000, 9000},
+    };
+
+    bool workspaceReallocated = false;
+    std::printf("%-8s %-20s %12s %12s %14s\n", "size", "stage", "median ms", "p95 ms", "allocs/call");
+    for (const InputSize &size : allSizes) {
+        const int mp = std::atoi(size.label);
+        if (std::find(megapixels.begin(), megapixels.end(), mp) == megapixels.end())
+            continue;
+
+        const cv::Mat image = makeSyntheticPage(size.width, size.height);
+
+        // Precompute each stage's input once so stages are timed independently
+        cv::Mat resized, edged;
+        const double ratio = resizeForDetection(image, resized);
+        detectEdges(resized, edged);
+        std::vector<std::vector<cv::Point>> contours;
+        findDocumentContours(edged, contours);
+        const std::vector<cv::Point> quad = selectDocumentQuad(contours, edged.size());
+        if (quad.empty()) {
+            std::fprintf(stderr, "%s: synthetic page not detected, skipping\n", size.label);
+            continue;
+        }
+        const std::vector<cv::Point2f> corners = refineCorners(image, quad, ratio);
+        const cv::Mat warped = fourPointTransform(image, corners);
+
+        std::vector<BenchResult> results;
+        results.push_back(runStage("resize", iterations, [&]() {
+            cv::Mat out;
+            resizeForDetection(image, out);
+        }));
+        results.push_back(runStage("canny", iterations, [&]() {
+            cv::Mat out;
+            detectEdges(resized, out);
+        }));
+        results.push_back(runStage("findContours", iterations, [&]() {
+            std::vector<std::vector<cv::Point>> out;
+            findDocumentContours(edged, out);
+        }));
+        results.push_back(runStage("approxPolyDP loop", iterations, [&]() {
+            selectDocumentQuad(contours, edged.size());
+        }));
+        results.push_back(runStage("cornerSubPix", iterations, [&]() {
+            refineCorners(image, quad, ratio);
+        }));
+        results.push_back(runStage("warpPerspective", iterations, [&]() {
+            fourPointTransform(image, corners);
+        }));
+        // Previous B/W path, kept as the baseline for the binarization engine
+        results.push_back(runStage("adaptiveThreshold", iterations, [&]() {
+            cv::Mat gray, out;
+            cv::cvtColor(warped, gray, cv::COLOR_BGR2GRAY);
+            cv::adaptiveThreshold(gray, out, 255, cv::ADAPTIVE_THRESH_MEAN_C, cv::THRESH_BINARY, 15, 10);
+        }));
+        results.push_back(runStage("binarize (Sauvola)", iterations, [&]() {
+            binarizeScan(warped);
+        }));
+        results.push_back(runStage("binarize (Wolf)", iterations, [&]() {
+            BinarizationParams params;
+            params.method = BinarizationMethod::Wolf;
+            params.dpi = estimateScanDpi(warped);
+            binarizeDocument(warped, params);
+        }));
+        results.push_back(runStage("snapDocument total", iterations, [&]() {
+            snapDocument(image, true);
+        }));
+        // Steady state of a batch worker: buffers already sized by earlier calls
+        SnapWorkspace workspace;
+        detectDocument(image, {}, workspace);
+        results.push_back(runStage("detect (fresh)", iterations, [&]() {
+            detectDocument(image);
+        }));
+        results.push_back(runStage("detect (workspace)", iterations, [&]() {
+            detectDocument(image, {}, workspace);
+        }));
+        // Where the workspace path still allocates: each stage reusing the
+        // same workspace, so only allocations inside OpenCV and the results
+        // are left
+        const double freshAllocs = results[results.size() - 2].allocsPerCall;
+        const double workspaceAllocs = results.back().allocsPerCall;
+        std::vector<std::vector<cv::Point>> &wsContours = workspace.contoursByWidth.front();
+        results.push_back(runStage("  ws resize", iterations, [&]() {
+            resizeForDetection(image, kDetectionWidth, workspace);
+        }));
+        results.push_back(runStage("  ws canny", iterations, [&]() {
+            detectEdges(workspace.resized, workspace.edged, true, workspace);
+        }));
+        results.push_back(runStage("  ws findContours", iterations, [&]() {
+            findDocumentContours(workspace.edged, wsContours);
+        }));
+        results.push_back(runStage("  ws quad search", iterations, [&]() {
+            selectDocumentQuad(wsContours, workspace.edged.size(), {}, workspace);
+        }));
+        results.push_back(runStage("  ws cornerSubPix", iterations, [&]() {
+            refineCorners(image, quad, ratio, workspace);
+        }));
+
+        // Cluttered desk: pruned top-k search against fitting every contour
+        const cv::Mat desk = makeSyntheticPage(size.width, size.height, true);
+        cv::Mat deskResized, deskEdged;
+        resizeForDetection(desk, deskResized);
+        detectEdges(deskResized, deskEdged);
+        std::vector<std::vector<cv::Point>> deskContours;
+        findDocumentContours(deskEdged, deskContours);
+        DetectionOptions exhaustive;
+        exhaustive.minCandidateBoxFraction = 0.0;
+        exhaustive.maxQuadCandidates = static_cast<int>(deskContours.size());
+        DetectionOptions external;
+        external.externalContoursOnly = true;
+        results.push_back(runStage("desk quad (all)", iterations, [&]() {
+            selectDocumentQuad(deskContours, deskEdged.size(), exhaustive);
+        }));
+        results.push_back(runStage("desk quad (top-k)", iterations, [&]() {
+            selectDocumentQuad(deskContours, deskEdged.size());
+        }));
+        results.push_back(runStage("desk detect LIST", iterations, [&]() {
+            detectDocument(desk);
+        }));
+        results.push_back(runStage("desk detect EXTERNAL", iterations, [&]() {
+            detectDocument(desk, external);
+        }));
+        std::printf("%-8s cluttered desk: %zu contours\n", size.label, deskContours.size());
+
+        for (const BenchResult &r : results) {
+            std::printf("%-8s %-20s %12.3f %12.3f %14.1f\n",
+                        size.label, r.stage.c_str(), r.medianMs, r.p95Ms, r.allocsPerCall);
+        }
+        // The workspace must not reallocate any of its own storage once
+        // settled, also when every detection width runs. What the counter
+        // still sees are OpenCV's per-call temporaries and the results.
+        DetectionOptions allWidths;
+        allWidths.escalateBelowConfidence = 2.0;  // above any confidence
+        const int reallocating = workspaceReallocations(image, {}, workspace, iterations)
+            + workspaceReallocations(image, allWidths, workspace, iterations);
+        std::printf("%-8s detect (workspace): %d of %d calls reallocated workspace storage; "
+                    "%.1f allocs/call inside OpenCV and the result (fresh workspace: %.1f)\n",
+                    size.label, reallocating, 2 * iterations, workspaceAllocs, freshAllocs);
+        if (reallocating > 0)
+            workspaceReallocated = true;
+    }
+    if (workspaceReallocated) {
+        std::fprintf(stderr, "detection reallocated workspace storage in steady state\n");
+        return 1;
+    }
+    return 0;
+}
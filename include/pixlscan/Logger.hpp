@@ -1,8 +1,9 @@
 #pragma once
 
-#include <iostream>
-#include <string>
 #include <cstdlib>
+#include <sstream>
+#include <string>
+#include <utility>
 
 enum class LogLevel {
     DEBUG,
@@ -12,8 +13,23 @@ enum class LogLevel {
     NONE
 };
 
+// Lowest level compiled into the binary (0 = DEBUG ... 4 = NONE); set via
+// PIXLSCAN_MIN_LOG_LEVEL in CMake. Calls below it lose their formatting and
+// sink call, but their arguments are still evaluated: wrap expensive ones in
+// if (Logger::enabled<LogLevel::DEBUG>()).
+#ifndef PIXLSCAN_MIN_LOG_LEVEL
+#define PIXLSCAN_MIN_LOG_LEVEL 0
+#endif
+
+// Messages are passed as a list of values, e.g.
+//     Logger::debug("area=", area, " among ", contours.size(), " contours");
+// and only formatted when their level is enabled. Formatted lines go to a
+// lock-free ring buffer drained by a background thread, so logging never
+// blocks on stdout/stderr; if the ring is full the line is dropped and counted.
 class Logger {
 public:
+    static constexpr LogLevel min_compiled_level = static_cast<LogLevel>(PIXLSCAN_MIN_LOG_LEVEL);
+
     static LogLevel get_level() {
         static LogLevel cached_level = []() {
             const char* env_log_level = std::getenv("LOG_LEVEL");
@@ -33,33 +49,55 @@ public:
         return cached_level;
     }
 
-    static void trace(const std::string& message) {
-        if (get_level() <= LogLevel::DEBUG) {
-            std::cout << "[TRACE] " << message << std::endl;
+    template <LogLevel Level>
+    static bool enabled() {
+        if constexpr (Level < min_compiled_level) {
+            return false;
+        } else {
+            return get_level() <= Level;
         }
     }
 
-    static void debug(const std::string& message) {
-        if (get_level() <= LogLevel::DEBUG) {
-            std::cout << "[DEBUG] " << message << std::endl;
-        }
+    template <typename... Args>
+    static void trace(const Args&... args) {
+        log<LogLevel::DEBUG>("[TRACE] ", args...);
     }
 
-    static void info(const std::string& message) {
-        if (get_level() <= LogLevel::INFO) {
-            std::cout << "[INFO] " << message << std::endl;
-        }
+    template <typename... Args>
+    static void debug(const Args&... args) {
+        log<LogLevel::DEBUG>("[DEBUG] ", args...);
     }
 
-    static void warn(const std::string& message) {
-        if (get_level() <= LogLevel::WARN) {
-            std::cerr << "[WARN] " << message << std::endl;
-        }
+    template <typename... Args>
+    static void info(const Args&... args) {
+        log<LogLevel::INFO>("[INFO] ", args...);
     }
 
-    static void error(const std::string& message) {
-        if (get_level() <= LogLevel::ERROR) {
-            std::cerr << "[ERROR] " << message << std::endl;
+    template <typename... Args>
+    static void warn(const Args&... args) {
+        log<LogLevel::WARN>("[WARN] ", args...);
+    }
+
+    template <typename... Args>
+    static void error(const Args&... args) {
+        log<LogLevel::ERROR>("[ERROR] ", args...);
+    }
+
+    // Block until every queued line has been written
+    static void flush();
+
+private:
+    template <LogLevel Level, typename... Args>
+    static void log(const char* tag, const Args&... args) {
+        if constexpr (Level >= min_compiled_level) {
+            if (get_level() <= Level) {
+                std::ostringstream line;
+                line << tag;
+                (line << ... << args);
+                write(Level, std::move(line).str());
+            }
         }
     }
+
+    static void write(LogLevel level, std::string line);
 };
@@ -0,0 +1,103 @@
+#include "auto_snap.h"
+#include "page_list.h"
+#include "Logger.hpp"
+#include <QThreadPool>
+#include <algorithm>
+
+AutoSnapScheduler::AutoSnapScheduler(PageListModel *model, QObject *parent)
+    : QObject(parent),
+      model(model),
+      // A job decoding its original runs a reduced preview alongside, so half
+      // the pool keeps threads free for the operator's own edits and tiles
+      maxRunning(static_cast<size_t>(std::max(1, QThreadPool::globalInstance()->maxThreadCount() / 2)))
+{
+    connect(model, &PageListModel::pageBusyChanged, this, &AutoSnapScheduler::onPageBusyChanged);
+    // A revert declines the snap, also for later runs
+    connect(model, &PageListModel::pageReverted, this, [this](ImageProcessingState *state) {
+        state->autoSnapTried = true;
+        queued.erase(state);
+    });
+    // setPages() destroys the processors, and with them the running jobs
+    connect(model, &PageListModel::modelAboutToBeReset, this, &AutoSnapScheduler::reset);
+}
+
+void AutoSnapScheduler::start()
+{
+    for (ImageProcessingState *state : model->pages()) {
+        if (!state->isSnapped() && !state->autoSnapTried && !running.count(state))
+            queued.insert(state);
+    }
+    Logger::debug("AutoSnap: ", queued.size(), " page(s) queued");
+    dispatch();
+}
+
+void AutoSnapScheduler::stop()
+{
+    queued.clear();
+}
+
+void AutoSnapScheduler::reset()
+{
+    queued.clear();
+    running.clear();
+    focusPage = nullptr;
+    firstVisible = lastVisible = -1;
+    cursor = 0;
+}
+
+void AutoSnapScheduler::setFocus(ImageProcessingState *current, int firstVisibleRow, int lastVisibleRow)
+{
+    focusPage = current;
+    firstVisible = firstVisibleRow;
+    lastVisible = lastVisibleRow;
+}
+
+void AutoSnapScheduler::onPageBusyChanged(ImageProcessingState *state, bool busy)
+{
+    // The page's processor only goes idle once its latest job is delivered
+    if (!busy && running.erase(state) > 0)
+        dispatch();
+}
+
+void AutoSnapScheduler::dispatch()
+{
+    while (running.size() < maxRunning) {
+        ImageProcessingState *state = takeNext();
+        if (!state)
+            break;
+        if (state->isSnapped())
+            continue;  // snapped by hand since it was queued
+        state->autoSnapTried = true;
+        running.insert(state);
+        model->snapPage(state, false);
+    }
+    if (queued.empty() && running.empty())
+        Logger::debug("AutoSnap: done");
+}
+
+// Remove and return the queued page with the highest priority
+ImageProcessingState *AutoSnapScheduler::takeNext()
+{
+    if (queued.empty())
+        return nullptr;
+    if (focusPage && queued.erase(focusPage) > 0)
+        return focusPage;
+    for (int row = std::max(firstVisible, 0); row >= 0 && row <= lastVisible; ++row) {
+        ImageProcessingState *state = model->page(row);
+        if (state && queued.erase(state) > 0)
+            return state;
+    }
+
+    // Page order, resuming where the last search stopped; wraps around for
+    // pages dragged behind the cursor
+    const std::vector<ImageProcessingState*> &pages = model->pages();
+    for (size_t scanned = 0; scanned < pages.size(); ++scanned) {
+        if (cursor >= pages.size())
+            cursor = 0;
+        ImageProcessingState *state = pages[cursor++];
+        if (queued.erase(state) > 0)
+            return state;
+    }
+    queued.clear();  // left over pages no longer in the model
+    return nullptr;
+}
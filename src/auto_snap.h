@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QObject>
+#include <cstddef>
+#include <unordered_set>
+#include "page_state.h"
+
+class PageListModel;
+
+// Snaps the pages of the processing view in the background, ahead of the
+// operator, so a page is usually processed by the time it is opened.
+//
+// Pages that are not snapped yet wait in priority order: the page in the
+// preview first, then the rows in view from the top, then the rest in page
+// order. The next page is picked whenever a job finishes, so scrolling or
+// selecting another page changes what runs next; jobs already running are
+// left alone. Each page is tried once: pages it ran on, and pages the
+// operator reverted, carry autoSnapTried (saved with the session) and are
+// not queued again when auto-snap is toggled or the view reopened. Pages
+// where no document is found are left as they were without an error badge,
+// since the operator never asked.
+class AutoSnapScheduler : public QObject {
+    Q_OBJECT
+public:
+    explicit AutoSnapScheduler(PageListModel *model, QObject *parent = nullptr);
+
+    // Queue every page of the model that is not snapped or tried yet and start
+    void start();
+    // Forget the queued pages; running jobs finish and their results apply
+    void stop();
+    bool isActive() const { return !queued.empty() || !running.empty(); }
+
+    // What the operator is looking at, favored when picking the next page
+    void setFocus(ImageProcessingState *current, int firstVisibleRow, int lastVisibleRow);
+
+private:
+    void onPageBusyChanged(ImageProcessingState *state, bool busy);
+    void dispatch();
+    ImageProcessingState *takeNext();
+    void reset();
+
+    PageListModel *model;
+    std::unordered_set<const ImageProcessingState*> queued;
+    std::unordered_set<const ImageProcessingState*> running;
+    ImageProcessingState *focusPage{nullptr};
+    int firstVisible{-1};
+    int lastVisible{-1};
+    size_t cursor{0};  // row where the search in page order resumes
+    size_t maxRunning;
+};
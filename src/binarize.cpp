@@ -0,0 +1,225 @@
+#include "binarize.h"
+#include <opencv2/core/hal/intrin.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+namespace {
+
+constexpr double kWindowInches = 1.0 / 6.0;
+constexpr double kPageWidthInches = 8.5;
+constexpr float kSauvolaRange = 128.0f;  // dynamic range of s for 8-bit images
+constexpr int kMinStripeRows = 64;
+
+// Threshold in the unified form T = (1 - k) * m + k * (M + s / R * (m - M)).
+// Sauvola is M = 0, R = 128; Wolf uses the image's darkest pixel and max s.
+struct ThresholdModel {
+    float k;
+    float minGray;   // M
+    float invRange;  // 1 / R
+};
+
+// Integral image rows bounding one output row's window
+struct WindowRows {
+    const int* sumTop;
+    const int* sumBottom;
+    const double* sqTop;
+    const double* sqBottom;
+    float height;  // window rows after clipping
+};
+
+inline void windowStats(const WindowRows& w, int x, int half, int width, float& mean, float& sd) {
+    const int x1 = max(0, x - half);
+    const int x2 = min(width, x + half + 1);
+    const float n = w.height * static_cast<float>(x2 - x1);
+    const float sum = static_cast<float>(w.sumBottom[x2] - w.sumBottom[x1] - w.sumTop[x2] + w.sumTop[x1]);
+    const float sq = static_cast<float>(w.sqBottom[x2] - w.sqBottom[x1] - w.sqTop[x2] + w.sqTop[x1]);
+    mean = sum / n;
+    sd = sqrt(max(0.0f, sq / n - mean * mean));
+}
+
+inline float thresholdFor(float mean, float sd, const ThresholdModel& model) {
+    return (1.0f - model.k) * mean + model.k * (model.minGray + sd * model.invRange * (mean - model.minGray));
+}
+
+#if CV_SIMD && CV_SIMD_64F
+// Mean and standard deviation for N = v_float32::nlanes interior pixels at x
+inline void windowStatsSimd(const WindowRows& w, int x, int half, const v_float32& invN,
+                            v_float32& mean, v_float32& sd) {
+    const int right = x + half + 1;
+    const int left = x - half;
+    const v_int32 sum = vx_load(w.sumBottom + right) - vx_load(w.sumBottom + left)
+                      - vx_load(w.sumTop + right) + vx_load(w.sumTop + left);
+    // Squared sums stay exact in double; only the window total is narrowed
+    const int halfLanes = v_float64::nlanes;
+    const v_float64 sqLo = vx_load(w.sqBottom + right) - vx_load(w.sqBottom + left)
+                         - vx_load(w.sqTop + right) + vx_load(w.sqTop + left);
+    const v_float64 sqHi = vx_load(w.sqBottom + right + halfLanes) - vx_load(w.sqBottom + left + halfLanes)
+                         - vx_load(w.sqTop + right + halfLanes) + vx_load(w.sqTop + left + halfLanes);
+    mean = v_cvt_f32(sum) * invN;
+    const v_float32 var = v_cvt_f32(sqLo, sqHi) * invN - mean * mean;
+    sd = v_sqrt(v_max(var, vx_setzero_f32()));
+}
+#endif
+
+void thresholdRow(const WindowRows& w, const uchar* gray, uchar* out, int width, int half,
+                  const ThresholdModel& model) {
+    auto scalar = [&](int x) {
+        float mean, sd;
+        windowStats(w, x, half, width, mean, sd);
+        out[x] = gray[x] > thresholdFor(mean, sd, model) ? 255 : 0;
+    };
+
+    int x = 0;
+    for (; x < min(half, width); ++x)
+        scalar(x);
+#if CV_SIMD && CV_SIMD_64F
+    const int lanes = v_float32::nlanes;
+    const v_float32 invN = vx_setall_f32(1.0f / (w.height * static_cast<float>(2 * half + 1)));
+    const v_float32 oneMinusK = vx_setall_f32(1.0f - model.k);
+    const v_float32 k = vx_setall_f32(model.k);
+    const v_float32 minGray = vx_setall_f32(model.minGray);
+    const v_float32 invRange = vx_setall_f32(model.invRange);
+    // Four float vectors of thresholds make one vector of output bytes
+    for (; x + 4 * lanes <= width - half; x += 4 * lanes) {
+        v_uint32 white[4];
+        for (int j = 0; j < 4; ++j) {
+            const int xj = x + j * lanes;
+            v_float32 mean, sd;
+            windowStatsSimd(w, xj, half, invN, mean, sd);
+            const v_float32 threshold = oneMinusK * mean + k * (minGray + sd * invRange * (mean - minGray));
+            const v_float32 pixel = v_cvt_f32(v_reinterpret_as_s32(vx_load_expand_q(gray + xj)));
+            white[j] = v_reinterpret_as_u32(pixel > threshold);
+        }
+        v_store(out + x, v_pack_b(white[0], white[1], white[2], white[3]));
+    }
+    vx_cleanup();
+#endif
+    for (; x < width; ++x)
+        scalar(x);
+}
+
+float maxStdInRow(const WindowRows& w, int width, int half) {
+    float maxSd = 0.0f;
+    auto scalar = [&](int x) {
+        float mean, sd;
+        windowStats(w, x, half, width, mean, sd);
+        maxSd = max(maxSd, sd);
+    };
+
+    int x = 0;
+    for (; x < min(half, width); ++x)
+        scalar(x);
+#if CV_SIMD && CV_SIMD_64F
+    const int lanes = v_float32::nlanes;
+    const v_float32 invN = vx_setall_f32(1.0f / (w.height * static_cast<float>(2 * half + 1)));
+    v_float32 maxVec = vx_setzero_f32();
+    for (; x + lanes <= width - half; x += lanes) {
+        v_float32 mean, sd;
+        windowStatsSimd(w, x, half, invN, mean, sd);
+        maxVec = v_max(maxVec, sd);
+    }
+    maxSd = max(maxSd, v_reduce_max(maxVec));
+    vx_cleanup();
+#endif
+    for (; x < width; ++x)
+        scalar(x);
+    return maxSd;
+}
+
+// Runs rowFn(window, y) for every row of one horizontal stripe, from
+// integral images of the stripe plus the window's halo above and below.
+// Stripe-local integrals keep 32-bit sums from overflowing and the working
+// set per thread small.
+template <typename RowFn>
+void forEachStripeRow(const Mat& gray, int half, int y0, int y1, RowFn rowFn) {
+    const int r0 = max(0, y0 - half);
+    const int r1 = min(gray.rows, y1 + half);
+    Mat sum, sqsum;
+    integral(gray.rowRange(r0, r1), sum, sqsum, CV_32S, CV_64F);
+    for (int y = y0; y < y1; ++y) {
+        const int top = max(0, y - half) - r0;
+        const int bottom = min(gray.rows, y + half + 1) - r0;
+        WindowRows w{sum.ptr<int>(top), sum.ptr<int>(bottom),
+                     sqsum.ptr<double>(top), sqsum.ptr<double>(bottom),
+                     static_cast<float>(bottom - top)};
+        rowFn(w, y);
+    }
+}
+
+int stripeRowsFor(int width, int half) {
+    // Largest stripe whose integral sums fit in 32 bits
+    const long long maxRows = INT_MAX / (255LL * (width + 1)) - 2LL * half;
+    return static_cast<int>(max(1LL, min<long long>(max(kMinStripeRows, 2 * half + 1), maxRows)));
+}
+
+} // namespace
+
+int binarizationWindowForDpi(double dpi) {
+    const int window = static_cast<int>(lround(dpi * kWindowInches));
+    return max(15, min(255, window | 1));
+}
+
+double estimateScanDpi(const Mat& page) {
+    if (page.empty())
+        return 300.0;
+    return min(page.cols, page.rows) / kPageWidthInches;
+}
+
+Mat binarizeDocument(const Mat& image, const BinarizationParams& params) {
+    if (image.empty() || image.depth() != CV_8U)
+        return Mat();
+
+    Mat gray;
+    if (image.channels() == 3)
+        cvtColor(image, gray, COLOR_BGR2GRAY);
+    else if (image.channels() == 4)
+        cvtColor(image, gray, COLOR_BGRA2GRAY);
+    else
+        gray = image;
+
+    const int window = params.windowSize > 0 ? (params.windowSize | 1) : binarizationWindowForDpi(params.dpi);
+    const int half = window / 2;
+    const int stripeRows = stripeRowsFor(gray.cols, half);
+    const int stripes = (gray.rows + stripeRows - 1) / stripeRows;
+    auto stripeRange = [&](int i) {
+        return make_pair(i * stripeRows, min(gray.rows, (i + 1) * stripeRows));
+    };
+
+    ThresholdModel model{static_cast<float>(params.k), 0.0f, 1.0f / kSauvolaRange};
+    if (params.method == BinarizationMethod::Wolf) {
+        // Wolf normalizes by the page's darkest pixel and largest local
+        // contrast, which needs a full statistics pass first
+        double minGray = 0.0;
+        minMaxLoc(gray, &minGray);
+        vector<float> stripeMax(static_cast<size_t>(stripes), 0.0f);
+        parallel_for_(Range(0, stripes), [&](const Range& range) {
+            for (int i = range.start; i < range.end; ++i) {
+                const auto [y0, y1] = stripeRange(i);
+                forEachStripeRow(gray, half, y0, y1, [&](const WindowRows& w, int) {
+                    stripeMax[static_cast<size_t>(i)] = max(stripeMax[static_cast<size_t>(i)],
+                                                            maxStdInRow(w, gray.cols, half));
+                });
+            }
+        });
+        const float maxSd = *max_element(stripeMax.begin(), stripeMax.end());
+        model.minGray = static_cast<float>(minGray);
+        model.invRange = 1.0f / max(1.0f, maxSd);
+    }
+
+    Mat binary(gray.size(), CV_8UC1);
+    parallel_for_(Range(0, stripes), [&](const Range& range) {
+        for (int i = range.start; i < range.end; ++i) {
+            const auto [y0, y1] = stripeRange(i);
+            forEachStripeRow(gray, half, y0, y1, [&](const WindowRows& w, int y) {
+                thresholdRow(w, gray.ptr<uchar>(y), binary.ptr<uchar>(y), gray.cols, half, model);
+            });
+        }
+    });
+    return binary;
+}
@@ -0,0 +1,46 @@
+#ifndef BINARIZE_H
+#define BINARIZE_H
+
+#include <opencv2/core.hpp>
+
+/** Local threshold model used by binarizeDocument(). */
+enum class BinarizationMethod {
+    Sauvola,  // T = m * (1 + k * (s / 128 - 1))
+    Wolf      // T = (1 - k) * m + k * M + k * s / max(s) * (m - M), M = darkest pixel
+};
+
+struct BinarizationParams {
+    BinarizationMethod method{BinarizationMethod::Sauvola};
+    double k{0.34};       // sensitivity; 0.2-0.5 works for both methods
+    int windowSize{0};    // odd window side in pixels; 0 = derive from dpi
+    double dpi{300.0};    // scan resolution used to size the window
+};
+
+/**
+ * Window side (odd, in pixels) covering about 1/6 inch at the given
+ * resolution: a few text strokes wide, so lighting gradients across the page
+ * do not leak into the threshold.
+ */
+int binarizationWindowForDpi(double dpi);
+
+/**
+ * Approximate resolution of a flattened page image, assuming its shorter
+ * side spans a letter/A4 page width (~8.5 inches).
+ */
+double estimateScanDpi(const cv::Mat& page);
+
+/**
+ * Binarize a page with a Sauvola or Wolf local threshold.
+ *
+ * Local mean and standard deviation come from integral images computed per
+ * horizontal stripe (stripes run in parallel via cv::parallel_for_), and the
+ * per-pixel threshold is vectorized with OpenCV universal intrinsics where
+ * available. Windows are clipped at the image border.
+ *
+ * @param image 8-bit gray, BGR or BGRA image.
+ * @return 8-bit single-channel image with text 0 and background 255; empty
+ *         if the input is empty or not 8-bit.
+ */
+cv::Mat binarizeDocument(const cv::Mat& image, const BinarizationParams& params = {});
+
+#endif // BINARIZE_H
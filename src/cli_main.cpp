@@ -0,0 +1,382 @@
+// Headless batch front-end: snaps every input image on a pool of worker
+// threads and writes the results next to each other in one output directory.
+// Links only OpenCV, so it runs under cron without a display server.
+#include "doc_snapper.h"
+#include "Logger.hpp"
+#include "trace.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#ifndef _WIN32
+#include <glob.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct CliOptions {
+    std::vector<std::string> inputs;
+    fs::path outputDir{"."};
+    std::string format{"png"};
+    bool returnColor{true};
+    unsigned jobs{0};  // 0 = one per hardware thread
+    double minConfidence{0.0};  // below this a snapped page is flagged for review
+    fs::path reportPath;        // optional per-file CSV report
+    DetectionOptions detection;
+};
+
+struct FileResult {
+    bool ok{false};
+    bool needsReview{false};
+    std::string message;
+    double seconds{0.0};
+    DocumentDetection detection;
+};
+
+void printUsage(const char *argv0)
+{
+    std::cout
+        << "Usage: " << argv0 << " [options] <input>...\n"
+        << "\n"
+        << "Inputs may be image files, directories (non-recursive) or glob\n"
+        << "patterns such as 'scans/*.jpg' (quote them to bypass the shell).\n"
+        << "\n"
+        << "Options:\n"
+        << "  -o, --output DIR   Output directory (default: current directory)\n"
+        << "  -f, --format FMT   Output format: png, jpg or bmp (default: png)\n"
+        << "      --bw           Produce a B/W scanned look instead of color\n"
+        << "  -j, --jobs N       Worker threads (default: all cores)\n"
+        << "      --min-confidence X\n"
+        << "                     Flag pages detected with confidence < X (0..1) for review\n"
+        << "      --report FILE  Write a per-file CSV with confidence and stage timings\n"
+        << "      --external-contours\n"
+        << "                     Search outermost contours only (faster on cluttered backgrounds)\n"
+        << "  -h, --help         Show this help\n";
+}
+
+bool isImageFile(const fs::path &path)
+{
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    // Same set the GUI file dialog accepts
+    return ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp"
+        || ext == ".tif" || ext == ".tiff";
+}
+
+bool hasWildcard(const std::string &s)
+{
+    return s.find_first_of("*?[") != std::string::npos;
+}
+
+// Expand files, directories and glob patterns into a sorted, de-duplicated list
+std::vector<fs::path> expandInputs(const std::vector<std::string> &inputs)
+{
+    std::set<fs::path> files;
+    for (const std::string &input : inputs) {
+        std::vector<fs::path> candidates;
+#ifndef _WIN32
+        if (hasWildcard(input)) {
+            glob_t g{};
+            if (glob(input.c_str(), 0, nullptr, &g) == 0) {
+                for (size_t i = 0; i < g.gl_pathc; ++i)
+                    candidates.emplace_back(g.gl_pathv[i]);
+            }
+            globfree(&g);
+            if (candidates.empty())
+                Logger::warn("No files match pattern: ", input);
+        } else
+#endif
+        {
+            candidates.emplace_back(input);
+        }
+
+        for (const fs::path &candidate : candidates) {
+            std::error_code ec;
+            if (fs::is_directory(candidate, ec)) {
+                for (const auto &entry : fs::directory_iterator(candidate, ec)) {
+                    if (entry.is_regular_file(ec) && isImageFile(entry.path()))
+                        files.insert(entry.path());
+                }
+            } else if (fs::is_regular_file(candidate, ec)) {
+                files.insert(candidate);
+            } else {
+                Logger::warn("Skipping missing input: ", candidate.string());
+            }
+        }
+    }
+    return {files.begin(), files.end()};
+}
+
+std::string toLower(std::string s)
+{
+    std::transform(s.begin(), s.end(), s.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return s;
+}
+
+// Output path for each input, in input order. Inputs sharing a stem (from
+// different directories or patterns) would overwrite each other from
+// parallel workers, so later ones get a "_2", "_3"... suffix. Compared
+// case-insensitively for case-insensitive file systems.
+std::vector<fs::path> outputPaths(const std::vector<fs::path> &files, const CliOptions &opts)
+{
+    std::unordered_set<std::string> taken;
+    std::vector<fs::path> paths;
+    paths.reserve(files.size());
+    for (const fs::path &file : files) {
+        const std::string stem = file.stem().string() + "_processed";
+        std::string name = stem;
+        for (int n = 2; !taken.insert(toLower(name)).second; ++n)
+            name = stem + "_" + std::to_string(n);
+        if (name != stem)
+            Logger::warn("Output name of ", file.string(), " is taken; writing ", name, ".", opts.format);
+        paths.push_back(opts.outputDir / (name + "." + opts.format));
+    }
+    return paths;
+}
+
+bool parseArgs(int argc, char *argv[], CliOptions &opts)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto needValue = [&](const char *name) -> const char * {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << name << "\n";
+                return nullptr;
+            }
+            return argv[++i];
+        };
+
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            std::exit(0);
+        } else if (arg == "-o" || arg == "--output") {
+            const char *v = needValue("--output");
+            if (!v) return false;
+            opts.outputDir = v;
+        } else if (arg == "-f" || arg == "--format") {
+            const char *v = needValue("--format");
+            if (!v) return false;
+            opts.format = toLower(v);
+            if (opts.format == "jpeg")
+                opts.format = "jpg";
+            if (opts.format != "png" && opts.format != "jpg" && opts.format != "bmp") {
+                std::cerr << "Unsupported format: " << v << "\n";
+                return false;
+            }
+        } else if (arg == "--bw") {
+            opts.returnColor = false;
+        } else if (arg == "-j" || arg == "--jobs") {
+            const char *v = needValue("--jobs");
+            if (!v) return false;
+            const int n = std::atoi(v);
+            if (n <= 0) {
+                std::cerr << "Invalid job count: " << v << "\n";
+                return false;
+            }
+            opts.jobs = static_cast<unsigned>(n);
+        } else if (arg == "--min-confidence") {
+            const char *v = needValue("--min-confidence");
+            if (!v) return false;
+            opts.minConfidence = std::atof(v);
+        } else if (arg == "--external-contours") {
+            opts.detection.externalContoursOnly = true;
+        } else if (arg == "--report") {
+            const char *v = needValue("--report");
+            if (!v) return false;
+            opts.reportPath = v;
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return false;
+        } else {
+            opts.inputs.push_back(arg);
+        }
+    }
+    if (opts.inputs.empty()) {
+        std::cerr << "No inputs given\n";
+        return false;
+    }
+    return true;
+}
+
+FileResult processFile(const fs::path &input, const fs::path &outPath, const CliOptions &opts,
+                       SnapWorkspace &workspace)
+{
+    FileResult result;
+    const auto start = std::chrono::steady_clock::now();
+
+    cv::Mat image = cv::imread(input.string(), cv::IMREAD_COLOR);
+    if (image.empty()) {
+        result.message = "failed to decode";
+    } else if (SnapResult snapped = snapDocumentDetailed(image, opts.returnColor, 0, opts.detection, workspace); snapped.detection.found) {
+        result.detection = snapped.detection;
+        result.needsReview = snapped.detection.confidence < opts.minConfidence;
+        try {
+            if (cv::imwrite(outPath.string(), snapped.image)) {
+                result.ok = true;
+                result.message = outPath.string();
+            } else {
+                result.message = "failed to write " + outPath.string();
+            }
+        } catch (const cv::Exception &e) {
+            result.message = "failed to write " + outPath.string() + ": " + e.what();
+        }
+    } else {
+        result.detection = snapped.detection;
+        result.message = "no document detected: " + snapped.detection.failureReason;
+    }
+
+    result.seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+// Quote a CSV field, doubling embedded quotes (RFC 4180)
+std::string csvQuote(const std::string &field)
+{
+    std::string quoted = "\"";
+    for (char c : field) {
+        if (c == '"')
+            quoted += '"';
+        quoted += c;
+    }
+    return quoted + '"';
+}
+
+// One row per input, in input order, for dashboards and review routing
+bool writeReport(const fs::path &path, const std::vector<fs::path> &files,
+                 const std::vector<FileResult> &results)
+{
+    std::ofstream out(path);
+    if (!out)
+        return false;
+    out << "file,status,confidence,area_fraction,angle_regularity,scale,"
+           "resize_ms,edges_ms,contours_ms,quad_search_ms,refine_ms,warp_ms,file_ms,message\n";
+    for (size_t i = 0; i < files.size(); ++i) {
+        const FileResult &r = results[i];
+        const DocumentDetection &d = r.detection;
+        const char *status = !r.ok ? "fail" : r.needsReview ? "review" : "ok";
+        out << csvQuote(files[i].string()) << ',' << status << ','
+            << d.confidence << ',' << d.areaFraction << ',' << d.angleRegularity << ',' << d.scale << ','
+            << d.timings.resizeMs << ',' << d.timings.edgesMs << ',' << d.timings.contoursMs << ','
+            << d.timings.quadSearchMs << ',' << d.timings.refineMs << ',' << d.timings.warpMs << ','
+            << r.seconds * 1000.0 << ',' << csvQuote(r.message) << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    CliOptions opts;
+    if (!parseArgs(argc, argv, opts)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    const std::vector<fs::path> files = expandInputs(opts.inputs);
+    if (files.empty()) {
+        Logger::error("No input images found");
+        return 2;
+    }
+
+    const std::vector<fs::path> outputs = outputPaths(files, opts);
+
+    std::error_code ec;
+    fs::create_directories(opts.outputDir, ec);
+    if (!fs::is_directory(opts.outputDir)) {
+        Logger::error("Cannot create output directory: ", opts.outputDir.string());
+        return 2;
+    }
+
+    unsigned jobs = opts.jobs ? opts.jobs : std::max(1u, std::thread::hardware_concurrency());
+    jobs = std::min<unsigned>(jobs, static_cast<unsigned>(files.size()));
+    // One image per core scales better than OpenCV splitting each image
+    // across cores, and avoids oversubscribing the machine.
+    if (jobs > 1)
+        cv::setNumThreads(1);
+
+    Logger::info("Processing ", files.size(), " image(s) on ", jobs, " thread(s)");
+    Logger::flush();  // keep the log line ahead of the progress output on stdout
+
+    std::vector<FileResult> results(files.size());
+    std::atomic<size_t> nextIndex{0};
+    std::mutex progressMutex;
+    size_t completed = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    auto worker = [&]() {
+        // Detection buffers grow to the batch's image sizes once, then are reused
+        SnapWorkspace workspace;
+        for (size_t i = nextIndex++; i < files.size(); i = nextIndex++) {
+            {
+                TraceSpan span("processFile", static_cast<int>(i));
+                results[i] = processFile(files[i], outputs[i], opts, workspace);
+            }
+            std::lock_guard<std::mutex> lock(progressMutex);
+            ++completed;
+            const char *status = !results[i].ok ? "FAIL  " : results[i].needsReview ? "REVIEW" : "OK    ";
+            std::cout << "[" << completed << "/" << files.size() << "] "
+                      << status << " " << files[i].string()
+                      << (results[i].ok ? " -> " : ": ") << results[i].message
+                      << " (" << static_cast<int>(results[i].seconds * 1000.0) << " ms";
+            if (results[i].ok)
+                std::cout << ", confidence " << results[i].detection.confidence;
+            std::cout << ")\n";
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(jobs);
+    for (unsigned t = 0; t < jobs; ++t)
+        pool.emplace_back(worker);
+    for (std::thread &t : pool)
+        t.join();
+    const double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    size_t okCount = 0;
+    size_t reviewCount = 0;
+    for (const FileResult &r : results) {
+        okCount += r.ok ? 1 : 0;
+        reviewCount += r.ok && r.needsReview ? 1 : 0;
+    }
+    const size_t failCount = files.size() - okCount;
+
+    if (!opts.reportPath.empty() && !writeReport(opts.reportPath, files, results))
+        Logger::error("Failed to write report: ", opts.reportPath.string());
+
+    std::cout << "\nSummary: " << okCount << " succeeded, " << failCount << " failed";
+    if (opts.minConfidence > 0.0)
+        std::cout << ", " << reviewCount << " flagged for review";
+    std::cout << "\n";
+    if (failCount > 0) {
+        for (size_t i = 0; i < files.size(); ++i) {
+            if (!results[i].ok)
+                std::cout << "  FAIL " << files[i].string() << ": " << results[i].message << "\n";
+        }
+    }
+    char throughput[128];
+    std::snprintf(throughput, sizeof(throughput),
+                  "Elapsed: %.2f s, throughput: %.2f images/sec (%u threads)\n",
+                  elapsed, elapsed > 0.0 ? static_cast<double>(files.size()) / elapsed : 0.0, jobs);
+    std::cout << throughput;
+
+    return failCount == 0 ? 0 : 1;
+}
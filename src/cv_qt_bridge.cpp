@@ -0,0 +1,83 @@
+#include "cv_qt_bridge.h"
+#include <QtGlobal>
+#include <opencv2/imgproc.hpp>
+
+namespace {
+
+void releaseMat(void *info)
+{
+    delete static_cast<cv::Mat *>(info);
+}
+
+// Keep `mat` alive for as long as the returned QImage (or any copy) exists
+QImage wrapMat(const cv::Mat &mat, QImage::Format format)
+{
+    auto *owner = new cv::Mat(mat);
+    return QImage(static_cast<const uchar *>(owner->data), owner->cols, owner->rows, static_cast<int>(owner->step),
+                  format, releaseMat, owner);
+}
+
+} // namespace
+
+QImage matToQImage(const cv::Mat &mat)
+{
+    if (mat.empty())
+        return QImage();
+    switch (mat.type()) {
+    case CV_8UC1:
+        return wrapMat(mat, QImage::Format_Grayscale8);
+    case CV_8UC3:
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+        return wrapMat(mat, QImage::Format_BGR888);
+#else
+    {
+        cv::Mat rgb;
+        cv::cvtColor(mat, rgb, cv::COLOR_BGR2RGB);
+        return wrapMat(rgb, QImage::Format_RGB888);
+    }
+#endif
+    case CV_8UC4:
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        return wrapMat(mat, QImage::Format_ARGB32);
+#else
+    {
+        cv::Mat argb;
+        const int fromTo[] = {0, 3, 1, 2, 2, 1, 3, 0};  // BGRA -> ARGB byte order
+        argb.create(mat.size(), CV_8UC4);
+        cv::mixChannels(&mat, 1, &argb, 1, fromTo, 4);
+        return wrapMat(argb, QImage::Format_ARGB32);
+    }
+#endif
+    default:
+        // Unsupported format
+        return QImage();
+    }
+}
+
+cv::Mat qImageToMat(const QImage &image)
+{
+    switch (image.format()) {
+    case QImage::Format_Grayscale8: {
+        cv::Mat mat(image.height(), image.width(), CV_8UC1, const_cast<uchar*>(image.constBits()), static_cast<size_t>(image.bytesPerLine()));
+        return mat.clone();
+    }
+    case QImage::Format_RGB888: {
+        cv::Mat mat(image.height(), image.width(), CV_8UC3, const_cast<uchar*>(image.constBits()), static_cast<size_t>(image.bytesPerLine()));
+        cv::Mat bgr;
+        cv::cvtColor(mat, bgr, cv::COLOR_RGB2BGR);
+        return bgr;
+    }
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    case QImage::Format_BGR888: {
+        cv::Mat mat(image.height(), image.width(), CV_8UC3, const_cast<uchar*>(image.constBits()), static_cast<size_t>(image.bytesPerLine()));
+        return mat.clone();
+    }
+#endif
+    case QImage::Format_ARGB32: {
+        cv::Mat mat(image.height(), image.width(), CV_8UC4, const_cast<uchar*>(image.constBits()), static_cast<size_t>(image.bytesPerLine()));
+        return mat.clone();
+    }
+    default:
+        return cv::Mat();
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <QImage>
+#include <opencv2/core.hpp>
+
+// Conversions between cv::Mat and QImage shared by every GUI call site.
+
+/**
+ * Wrap a cv::Mat in a QImage without copying pixels.
+ *
+ * The QImage shares ownership of the Mat's buffer (the Mat's reference count
+ * is held until the last QImage copy is destroyed), reads rows through the
+ * Mat's stride so ROIs and padded mats work, and uses BGR-native formats:
+ * CV_8UC1 -> Grayscale8, CV_8UC3 -> BGR888, CV_8UC4 -> ARGB32 (BGRA in memory
+ * on little-endian hosts). The image is read-only: any non-const access
+ * detaches into a private copy, so the Mat is never written through it.
+ *
+ * Qt older than 5.14 has no BGR888; 3-channel mats then cost one cvtColor.
+ * Unsupported types return a null QImage.
+ */
+QImage matToQImage(const cv::Mat &mat);
+
+/** Deep-copy a QImage into a BGR/BGRA/gray cv::Mat. Unsupported formats return an empty Mat. */
+cv::Mat qImageToMat(const QImage &image);
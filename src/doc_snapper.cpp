@@ -1,34 +1,35 @@
 #include "doc_snapper.h"
+#include "doc_snapper_stages.h"
+#include "binarize.h"
 #include <opencv2/opencv.hpp>
 #include <iostream>
 #include "Logger.hpp"
+#include "trace.h"
 #include <algorithm>
+#include <array>
+#include <chrono>
 
 using namespace cv;
 using namespace std;
 
-static vector<Point2f> orderPoints(const vector<Point>& pts) {
-    vector<Point2f> pts2f(pts.begin(), pts.end());
+static vector<Point2f> orderPoints(array<Point2f, 4> pts) {
     // Sort by x (left to right)
-    sort(pts2f.begin(), pts2f.end(), [](const Point2f& a, const Point2f& b) {
+    sort(pts.begin(), pts.end(), [](const Point2f& a, const Point2f& b) {
         return a.x < b.x;
     });
 
-    vector<Point2f> left(pts2f.begin(), pts2f.begin() + 2);
-    vector<Point2f> right(pts2f.begin() + 2, pts2f.end());
-
-    sort(left.begin(), left.end(), [](const Point2f& a, const Point2f& b) {
-        return a.y < b.y;
-    });
-    sort(right.begin(), right.end(), [](const Point2f& a, const Point2f& b) {
+    // Then each pair top to bottom
+    auto byY = [](const Point2f& a, const Point2f& b) {
         return a.y < b.y;
-    });
+    };
+    sort(pts.begin(), pts.begin() + 2, byY);
+    sort(pts.begin() + 2, pts.end(), byY);
 
-    return { left[0], right[0], right[1], left[1] }; // TL, TR, BR, BL
+    return { pts[0], pts[2], pts[3], pts[1] }; // TL, TR, BR, BL
 }
 
 
-static Mat fourPointTransform(const Mat& image, const vector<Point2f>& ordered) {
+Mat fourPointTransform(const Mat& image, const vector<Point2f>& ordered, int rotationAngle) {
     Point2f tl = ordered[0];
     Point2f tr = ordered[1];
     Point2f br = ordered[2];
@@ -41,7 +42,8 @@ static Mat fourPointTransform(const Mat& image, const vector<Point2f>& ordered)
     double heightB = norm(tl - bl);
     double maxHeight = max(heightA, heightB);
     // Debug: log dimensions
-    Logger::debug(std::string("fourPointTransform: widthA=") + std::to_string(widthA) + " widthB=" + std::to_string(widthB) + " maxWidth=" + std::to_string(maxWidth) + " heightA=" + std::to_string(heightA) + " heightB=" + std::to_string(heightB) + " maxHeight=" + std::to_string(maxHeight));
+    Logger::debug("fourPointTransform: widthA=", widthA, " widthB=", widthB, " maxWidth=", maxWidth,
+                  " heightA=", heightA, " heightB=", heightB, " maxHeight=", maxHeight);
 
     Point2f src[4] = { tl, tr, br, bl };
     Point2f dst[4] = {
@@ -50,38 +52,172 @@ static Mat fourPointTransform(const Mat& image, const vector<Point2f>& ordered)
         {static_cast<float>(maxWidth - 1), static_cast<float>(maxHeight - 1)},
         {0, static_cast<float>(maxHeight - 1)}
     };
+    Size outSize(static_cast<int>(maxWidth), static_cast<int>(maxHeight));
+
+    // Fold a clockwise quarter-turn rotation into the destination corners so
+    // the single warp produces the rotated page directly.
+    const float w1 = static_cast<float>(maxWidth - 1);
+    const float h1 = static_cast<float>(maxHeight - 1);
+    for (Point2f& p : dst) {
+        const Point2f q = p;
+        switch (rotationAngle) {
+        case 90:  p = Point2f(h1 - q.y, q.x); break;
+        case 180: p = Point2f(w1 - q.x, h1 - q.y); break;
+        case 270: p = Point2f(q.y, w1 - q.x); break;
+        default: break;
+        }
+    }
+    if (rotationAngle == 90 || rotationAngle == 270)
+        outSize = Size(outSize.height, outSize.width);
+
     Mat M = getPerspectiveTransform(src, dst);
     Mat warped;
-    warpPerspective(image, warped, M, Size(static_cast<int>(maxWidth), static_cast<int>(maxHeight)));
+    warpPerspective(image, warped, M, outSize);
     return warped;
 }
 
-std::optional<cv::Mat> snapDocument(const cv::Mat& image, bool returnColor) {
-    if (image.empty()) {
-        Logger::error("snapDocument: empty input image");
-        return std::nullopt;
+// Size of `imageSize` downsampled to `width`
+static Size detectionSize(Size imageSize, int width) {
+    const double ratio = static_cast<double>(imageSize.width) / width;
+    return Size(width, max(1, static_cast<int>(imageSize.height / ratio)));
+}
+
+// Grow `buffer`, a single row of bytes, to hold at least `bytes`
+static void reserveBuffer(Mat& buffer, size_t bytes) {
+    if (buffer.total() < bytes)
+        buffer.create(1, static_cast<int>(bytes), CV_8U);
+}
+
+// Point `view` at the start of `buffer` as a `size` image of `type`. OpenCV
+// functions writing into a view of matching size and type fill it in place,
+// so every detection width shares the buffer instead of allocating its own.
+static void viewInto(Mat& buffer, Mat& view, Size size, int type) {
+    reserveBuffer(buffer, static_cast<size_t>(size.area()) * CV_ELEM_SIZE(type));
+    view = Mat(size, type, buffer.data);
+}
+
+double resizeForDetection(const Mat& image, Mat& resized, int width) {
+    if (image.cols <= width) {
+        resized = image;
+        return 1.0;
     }
-    // 1. Pre-process: downsample, gray, blur, and edge-detect
-    constexpr int kResizeWidth = 600;
-    const double ratio = static_cast<double>(image.cols) / kResizeWidth;
-    Mat resized;
-    cv::resize(image, resized,
-               Size(kResizeWidth, static_cast<int>(image.rows / ratio)),
-               0, 0, INTER_AREA);
-    Mat gray, blurred, edged;
+    // A reused `resized` may still alias an earlier input from the branch
+    // above; resizing into it would overwrite that caller's pixels
+    if (!resized.u || resized.u->refcount > 1)
+        resized.release();
+    cv::resize(image, resized, detectionSize(image.size(), width), 0, 0, INTER_AREA);
+    return static_cast<double>(image.cols) / width;
+}
+
+double resizeForDetection(const Mat& image, int width, SnapWorkspace& workspace) {
+    if (image.cols <= width) {
+        workspace.resized = image;
+        return 1.0;
+    }
+    // Re-pointed at the workspace's own buffer, so it never writes into an
+    // earlier input that the branch above handed back
+    const Size size = detectionSize(image.size(), width);
+    viewInto(workspace.resizedBuffer, workspace.resized, size, image.type());
+    cv::resize(image, workspace.resized, size, 0, 0, INTER_AREA);
+    return static_cast<double>(image.cols) / width;
+}
+
+static int medianIntensity(const Mat& gray) {
+    int histogram[256] = {0};
+    for (int y = 0; y < gray.rows; ++y) {
+        const uchar* row = gray.ptr<uchar>(y);
+        for (int x = 0; x < gray.cols; ++x)
+            ++histogram[row[x]];
+    }
+    const size_t half = gray.total() / 2;
+    size_t seen = 0;
+    for (int v = 0; v < 256; ++v) {
+        seen += static_cast<size_t>(histogram[v]);
+        if (seen > half)
+            return v;
+    }
+    return 255;
+}
+
+void detectEdges(const Mat& resized, Mat& edged, bool autoThresholds) {
+    SnapWorkspace workspace;
+    detectEdges(resized, edged, autoThresholds, workspace);
+}
+
+void detectEdges(const Mat& resized, Mat& edged, bool autoThresholds, SnapWorkspace& workspace) {
+    Mat& gray = workspace.gray;
+    Mat& blurred = workspace.blurred;
+    viewInto(workspace.grayBuffer, gray, resized.size(), CV_8UC1);
+    viewInto(workspace.blurredBuffer, blurred, resized.size(), CV_8UC1);
     cvtColor(resized, gray, COLOR_BGR2GRAY);
     GaussianBlur(gray, blurred, Size(5, 5), 0);
-    Canny(blurred, edged, 75, 200);
+    double lower = 75.0;
+    double upper = 200.0;
+    if (autoThresholds) {
+        // Thresholds follow the scene's exposure instead of assuming one
+        constexpr double kSigma = 0.33;
+        // A near-black frame (lens cap, dark scan) has a median close to 0;
+        // thresholds derived from it would keep every noise gradient
+        constexpr double kMinLower = 10.0;
+        const double median = medianIntensity(blurred);
+        lower = max(kMinLower, (1.0 - kSigma) * median);
+        upper = min(255.0, max(2.0 * lower, (1.0 + kSigma) * median));
+    }
+    Canny(blurred, edged, lower, upper);
+}
 
-    // 2. Find contours on resized image
-    vector<vector<Point>> contours;
-    findContours(edged, contours, RETR_LIST, CHAIN_APPROX_SIMPLE);
+void findDocumentContours(const Mat& edged, vector<vector<Point>>& contours, bool externalOnly) {
+    // findContours sizes the list itself; clearing it first would free the
+    // storage of every contour a reused list could have kept
+    findContours(edged, contours, externalOnly ? RETR_EXTERNAL : RETR_LIST, CHAIN_APPROX_SIMPLE);
+}
+
+vector<size_t> rankQuadCandidates(const vector<vector<Point>>& contours, Size frameSize,
+                                  const DetectionOptions& options) {
+    SnapWorkspace workspace;
+    rankQuadCandidates(contours, frameSize, options, workspace);
+    return std::move(workspace.ranked);
+}
+
+void rankQuadCandidates(const vector<vector<Point>>& contours, Size frameSize,
+                        const DetectionOptions& options, SnapWorkspace& workspace) {
+    // Bounding boxes are cheap and reject the thousands of tiny texture
+    // contours before any per-point work
+    const double minBoxArea = options.minCandidateBoxFraction * frameSize.area();
+    vector<pair<double, size_t>>& candidates = workspace.candidates;
+    candidates.clear();
+    for (size_t i = 0; i < contours.size(); ++i) {
+        if (boundingRect(contours[i]).area() >= minBoxArea)
+            candidates.emplace_back(fabs(contourArea(contours[i])), i);
+    }
+
+    const size_t keep = min(candidates.size(), static_cast<size_t>(max(0, options.maxQuadCandidates)));
+    partial_sort(candidates.begin(), candidates.begin() + keep, candidates.end(),
+                 [](const pair<double, size_t>& a, const pair<double, size_t>& b) {
+                     return a.first > b.first;
+                 });
+    vector<size_t>& ranked = workspace.ranked;
+    ranked.clear();
+    for (size_t i = 0; i < keep; ++i)
+        ranked.push_back(candidates[i].second);
+}
+
+vector<Point> selectDocumentQuad(const vector<vector<Point>>& contours, Size frameSize,
+                                 const DetectionOptions& options) {
+    SnapWorkspace workspace;
+    selectDocumentQuad(contours, frameSize, options, workspace);
+    return std::move(workspace.quad);
+}
 
-    // 3. Locate the largest 4‑point convex contour
-    vector<Point> docContour;
+void selectDocumentQuad(const vector<vector<Point>>& contours, Size frameSize,
+                        const DetectionOptions& options, SnapWorkspace& workspace) {
+    vector<Point>& docContour = workspace.quad;
+    docContour.clear();
     double maxArea = 0.0;
-    for (const auto& cnt : contours) {
-        vector<Point> approx;
+    vector<Point>& approx = workspace.approx;
+    rankQuadCandidates(contours, frameSize, options, workspace);
+    for (size_t index : workspace.ranked) {
+        const vector<Point>& cnt = contours[index];
         double peri = arcLength(cnt, true);
         approxPolyDP(cnt, approx, 0.02 * peri, true);
         if (approx.size() == 4 && isContourConvex(approx)) {
@@ -89,53 +225,316 @@ std::optional<cv::Mat> snapDocument(const cv::Mat& image, bool returnColor) {
             if (area > maxArea) {
                 maxArea = area;
                 docContour = approx;
-                // Log new max contour
-                Logger::debug("snapDocument: new max contour area=" + std::to_string(maxArea) + " pts:");
-                for (const auto& p : docContour) Logger::debug("max contour point (" + std::to_string(p.x) + "," + std::to_string(p.y) + ")");
-                Logger::debug("");
             }
         }
     }
-    if (docContour.empty()) {
-        Logger::warn("snapDocument: no document contour found");
-        return std::nullopt;
+    if (!docContour.empty()) {
+        Logger::debug("snapDocument: selected contour area=", maxArea, " among ", contours.size(), " contours");
     }
+}
+
+namespace {
+
+// cornerSubPix half-windows: at full resolution, and at the intermediate
+// scale where it must absorb the detection resolution's rounding error
+const Size kFineWindow(5, 5);
+const Size kCoarseWindow(7, 7);
+// Below this intermediate downscale the full-resolution pass suffices
+constexpr double kMinCoarseFactor = 2.0;
+
+// Refine one corner on a small gray patch around it, optionally downscaled
+// by `factor`. Only the patch is converted to gray, never the whole image.
+// `scaledBuffer`, `grayBuffer` and `point` are scratch storage reused across
+// calls; the patches are views into the buffers, which only ever grow.
+Point2f refineCornerInPatch(const Mat& image, Point2f corner, double factor, Size window,
+                            const TermCriteria& criteria, Mat& scaledBuffer, Mat& grayBuffer,
+                            vector<Point2f>& point) {
+    // Room for the search window plus the distance the corner may move
+    const int patchRadius = 2 * window.width + 2;
+    const int fullRadius = cvCeil(patchRadius * factor);
+    Rect roi(cvFloor(corner.x) - fullRadius, cvFloor(corner.y) - fullRadius,
+             2 * fullRadius + 1, 2 * fullRadius + 1);
+    roi &= Rect(0, 0, image.cols, image.rows);
+    if (roi.empty())
+        return corner;
+
+    Mat patch = image(roi);
+    if (factor > 1.0) {
+        const Size scaledSize(max(1, cvRound(roi.width / factor)), max(1, cvRound(roi.height / factor)));
+        Mat scaled;
+        viewInto(scaledBuffer, scaled, scaledSize, image.type());
+        resize(patch, scaled, scaledSize, 0, 0, INTER_AREA);
+        patch = scaled;
+    }
+    // A patch that is gray already is read as is
+    Mat gray = patch;
+    if (patch.channels() == 3 || patch.channels() == 4) {
+        viewInto(grayBuffer, gray, patch.size(), CV_8UC1);
+        cvtColor(patch, gray, patch.channels() == 3 ? COLOR_BGR2GRAY : COLOR_BGRA2GRAY);
+    }
+    // cornerSubPix needs the whole window plus a border inside the patch
+    if (gray.cols < 2 * window.width + 5 || gray.rows < 2 * window.height + 5)
+        return corner;
+
+    // Map pixel centers between full-resolution and patch coordinates
+    const float fx = static_cast<float>(roi.width) / gray.cols;
+    const float fy = static_cast<float>(roi.height) / gray.rows;
+    point.assign(1, Point2f((corner.x - roi.x + 0.5f) / fx - 0.5f,
+                            (corner.y - roi.y + 0.5f) / fy - 0.5f));
+    cornerSubPix(gray, point, window, Size(-1, -1), criteria);
+    return Point2f(roi.x + (point[0].x + 0.5f) * fx - 0.5f,
+                   roi.y + (point[0].y + 0.5f) * fy - 0.5f);
+}
+
+} // namespace
+
+vector<Point2f> refineCorners(const Mat& image, const vector<Point>& quad, double ratio) {
+    SnapWorkspace workspace;
+    return refineCorners(image, quad, ratio, workspace);
+}
+
+vector<Point2f> refineCorners(const Mat& image, const vector<Point>& quad, double ratio,
+                              SnapWorkspace& workspace) {
     // Scale contour points back to original image size
-    vector<Point> scaledContour;
-    scaledContour.reserve(docContour.size());
-    for (const auto& p : docContour) {
-        scaledContour.emplace_back(
-            static_cast<int>(p.x * ratio),
-            static_cast<int>(p.y * ratio)
+    array<Point2f, 4> scaledContour;
+    for (size_t i = 0; i < scaledContour.size() && i < quad.size(); ++i) {
+        scaledContour[i] = Point2f(
+            static_cast<float>(quad[i].x * ratio),
+            static_cast<float>(quad[i].y * ratio)
         );
     }
 
-    // 4. Warp perspective on original image
     // Debug: log selected (scaled) contour
-    Logger::debug("snapDocument: selected docContour points:");
-    for (const auto& p : scaledContour) Logger::debug("scaled contour point (" + std::to_string(p.x) + "," + std::to_string(p.y) + ")");
-    Logger::debug("");
+    Logger::debug("snapDocument: scaled contour points ", scaledContour[0], " ", scaledContour[1], " ",
+                  scaledContour[2], " ", scaledContour[3]);
     auto ordered = orderPoints(scaledContour);
-    // 4.a Refine corner points to subpixel accuracy
-    Mat grayOrig;
-    cvtColor(image, grayOrig, COLOR_BGR2GRAY);
-    const cv::Size winSize(5, 5);
-    const cv::Size zeroZone(-1, -1);
+    // Refine corner points to subpixel accuracy, coarse to fine: a detection
+    // pixel spans `ratio` full-resolution pixels, more than a 5x5 window can
+    // recover, so first refine at an intermediate scale halfway (in log
+    // terms) between detection and full resolution.
     const TermCriteria criteria(TermCriteria::EPS + TermCriteria::MAX_ITER, 30, 0.1);
-    cornerSubPix(grayOrig, ordered, winSize, zeroZone, criteria);
+    const double coarseFactor = sqrt(ratio);
+    for (Point2f& corner : ordered) {
+        if (coarseFactor >= kMinCoarseFactor) {
+            corner = refineCornerInPatch(image, corner, coarseFactor, kCoarseWindow, criteria,
+                                         workspace.coarsePatch, workspace.coarsePatchGray, workspace.subPixPoint);
+        }
+        // The full-resolution patch needs no scaling; `coarsePatch` is unused there
+        corner = refineCornerInPatch(image, corner, 1.0, kFineWindow, criteria,
+                                     workspace.coarsePatch, workspace.finePatchGray, workspace.subPixPoint);
+    }
     // Debug: log ordered corners
-    Logger::debug("snapDocument: ordered corners TL=" + std::to_string(ordered[0].x) + "," + std::to_string(ordered[0].y) + " TR=" + std::to_string(ordered[1].x) + "," + std::to_string(ordered[1].y) + " BR=" + std::to_string(ordered[2].x) + "," + std::to_string(ordered[2].y) + " BL=" + std::to_string(ordered[3].x) + "," + std::to_string(ordered[3].y));
+    Logger::debug("snapDocument: ordered corners TL=", ordered[0], " TR=", ordered[1],
+                  " BR=", ordered[2], " BL=", ordered[3]);
+    return ordered;
+}
+
+Mat binarizeScan(const Mat& warped) {
+    // scanner-like B/W enhancement; the window follows the page's resolution
+    BinarizationParams params;
+    params.dpi = estimateScanDpi(warped);
+    return binarizeDocument(warped, params);
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - since).count();
+}
+
+// Interior angles close to 90 degrees score 1; a degenerate quad scores 0.
+double angleRegularity(const vector<Point2f>& quad) {
+    double deviation = 0.0;
+    for (size_t i = 0; i < 4; ++i) {
+        const Point2f prev = quad[(i + 3) % 4];
+        const Point2f cur = quad[i];
+        const Point2f next = quad[(i + 1) % 4];
+        const Point2f a = prev - cur;
+        const Point2f b = next - cur;
+        const double denom = norm(a) * norm(b);
+        if (denom <= 0.0)
+            return 0.0;
+        const double cosAngle = std::clamp(a.dot(b) / denom, -1.0, 1.0);
+        deviation += fabs(acos(cosAngle) * 180.0 / CV_PI - 90.0);
+    }
+    return std::max(0.0, 1.0 - deviation / (4 * 90.0));
+}
+
+} // namespace
+
+double SnapStageTimings::totalMs() const {
+    return resizeMs + edgesMs + contoursMs + quadSearchMs + refineMs + warpMs;
+}
+
+// One detection pass at a single detection width. Timings accumulate into
+// `timings` so a multi-scale search reports its total cost per stage.
+static DocumentDetection detectAtWidth(const Mat& image, int width, const DetectionOptions& options,
+                                       vector<vector<Point>>& contours, SnapStageTimings& timings,
+                                       SnapWorkspace& workspace) {
+    TraceSpan span("detectAtWidth");
+    DocumentDetection result;
+    // 1. Pre-process: downsample, gray, blur, and edge-detect
+    const Mat& resized = workspace.resized;
+    Mat& edged = workspace.edged;
+    auto start = Clock::now();
+    result.scale = resizeForDetection(image, width, workspace);
+    timings.resizeMs += elapsedMs(start);
+
+    start = Clock::now();
+    viewInto(workspace.edgedBuffer, edged, resized.size(), CV_8UC1);
+    detectEdges(resized, edged, options.autoCannyThresholds, workspace);
+    timings.edgesMs += elapsedMs(start);
+
+    // 2. Find contours on resized image
+    start = Clock::now();
+    findDocumentContours(edged, contours, options.externalContoursOnly);
+    timings.contoursMs += elapsedMs(start);
+
+    // 3. Locate the largest 4-point convex contour
+    start = Clock::now();
+    selectDocumentQuad(contours, edged.size(), options, workspace);
+    const vector<Point>& docContour = workspace.quad;
+    timings.quadSearchMs += elapsedMs(start);
+    if (docContour.empty()) {
+        result.failureReason = "no convex quadrilateral contour among " + std::to_string(contours.size())
+            + " contours at width " + std::to_string(resized.cols);
+        return result;
+    }
+
+    // 4. Scale back, order and refine corners on the original image
+    start = Clock::now();
+    result.corners = refineCorners(image, docContour, result.scale, workspace);
+    timings.refineMs += elapsedMs(start);
+
+    // Confidence: a near-rectangular quad covering a reasonable share of the
+    // frame. Pages filling less than kConfidentArea are penalised linearly.
+    constexpr double kConfidentArea = 0.25;
+    result.areaFraction = fabs(contourArea(result.corners)) / (static_cast<double>(image.cols) * image.rows);
+    result.angleRegularity = angleRegularity(result.corners);
+    result.confidence = std::min(1.0, result.areaFraction / kConfidentArea) * result.angleRegularity;
+    result.found = true;
+    return result;
+}
+
+// Grow the workspace for the finest of `widths` up front, so the coarser
+// widths tried before it work in the same buffers
+static void reserveForWidths(const Mat& image, const vector<int>& widths, SnapWorkspace& workspace) {
+    size_t resizedBytes = 0;
+    size_t grayBytes = 0;
+    for (int requested : widths) {
+        const int width = std::min(requested, image.cols);
+        if (width <= 0)
+            continue;
+        const size_t pixels = static_cast<size_t>(detectionSize(image.size(), width).area());
+        grayBytes = max(grayBytes, pixels);
+        if (width < image.cols)  // otherwise the input is used as is
+            resizedBytes = max(resizedBytes, pixels * image.elemSize());
+    }
+    reserveBuffer(workspace.resizedBuffer, resizedBytes);
+    reserveBuffer(workspace.grayBuffer, grayBytes);
+    reserveBuffer(workspace.blurredBuffer, grayBytes);
+    reserveBuffer(workspace.edgedBuffer, grayBytes);
+    if (workspace.contoursByWidth.size() < widths.size())
+        workspace.contoursByWidth.resize(widths.size());
+}
+
+DocumentDetection detectDocument(const cv::Mat& image, const DetectionOptions& options) {
+    SnapWorkspace workspace;
+    return detectDocument(image, options, workspace);
+}
+
+DocumentDetection detectDocument(const cv::Mat& image, const DetectionOptions& options,
+                                 SnapWorkspace& workspace) {
+    TraceSpan span("detectDocument");
+    DocumentDetection best;
+    if (image.empty()) {
+        Logger::error("detectDocument: empty input image");
+        best.failureReason = "empty input image";
+        return best;
+    }
+
+    // Coarse to fine: most photos resolve at the first, cheapest width, and
+    // finer widths only run while no confident quad has been found.
+    SnapStageTimings timings;
+    const vector<int>& widths = options.detectionWidths;
+    reserveForWidths(image, widths, workspace);
+    int lastWidth = 0;
+    for (size_t i = 0; i < widths.size(); ++i) {
+        const int width = std::min(widths[i], image.cols);
+        if (width <= lastWidth)
+            continue;  // image narrower than this step: already tried at full size
+        lastWidth = width;
+
+        DocumentDetection attempt = detectAtWidth(image, width, options, workspace.contoursByWidth[i],
+                                                  timings, workspace);
+        // Until something is found, keep the latest failure reason
+        const bool better = attempt.found ? (!best.found || attempt.confidence > best.confidence) : !best.found;
+        if (better)
+            best = std::move(attempt);
+        if (best.found && best.confidence >= options.escalateBelowConfidence)
+            break;
+        const bool finerWidthFollows = any_of(widths.begin() + i + 1, widths.end(),
+                                              [&](int next) { return std::min(next, image.cols) > width; });
+        if (finerWidthFollows)
+            Logger::debug("detectDocument: escalating past width ", width);
+    }
+    if (!best.found) {
+        Logger::warn("detectDocument: no document contour found");
+        if (best.failureReason.empty())
+            best.failureReason = "no detection widths configured";
+    }
+    best.timings = timings;
+    return best;
+}
+
+std::optional<std::vector<cv::Point2f>> detectDocumentCorners(const cv::Mat& image) {
+    DocumentDetection detection = detectDocument(image);
+    if (!detection.found)
+        return std::nullopt;
+    return std::move(detection.corners);
+}
+
+cv::Mat warpDocument(const cv::Mat& image, const std::vector<cv::Point2f>& corners,
+                     bool returnColor, int rotationAngle) {
+    TraceSpan span("warpDocument");
     // 5. Warp full-color image and return per mode
-    Mat warped = fourPointTransform(image, ordered);
+    Mat warped = fourPointTransform(image, corners, rotationAngle);
     if (returnColor) {
         return warped;  // full-color perspective-corrected image
-    } else {
-        // scanner-like B/W enhancement
-        Mat warpedGray, enhanced;
-        cvtColor(warped, warpedGray, COLOR_BGR2GRAY);
-        adaptiveThreshold(warpedGray, enhanced,
-                          255, ADAPTIVE_THRESH_MEAN_C,
-                          THRESH_BINARY, 15, 10);
-        return enhanced;
     }
+    return binarizeScan(warped);
+}
+
+SnapResult snapDocumentDetailed(const cv::Mat& image, bool returnColor, int rotationAngle,
+                                const DetectionOptions& options) {
+    SnapWorkspace workspace;
+    return snapDocumentDetailed(image, returnColor, rotationAngle, options, workspace);
+}
+
+SnapResult snapDocumentDetailed(const cv::Mat& image, bool returnColor, int rotationAngle,
+                                const DetectionOptions& options, SnapWorkspace& workspace) {
+    TraceSpan span("snapDocument");
+    SnapResult result;
+    result.detection = detectDocument(image, options, workspace);
+    if (!result.detection.found)
+        return result;
+    const auto start = Clock::now();
+    result.image = warpDocument(image, result.detection.corners, returnColor, rotationAngle);
+    result.detection.timings.warpMs = elapsedMs(start);
+    return result;
+}
+
+std::optional<cv::Mat> snapDocument(const cv::Mat& image, bool returnColor, int rotationAngle) {
+    SnapWorkspace workspace;
+    return snapDocument(image, returnColor, rotationAngle, workspace);
+}
+
+std::optional<cv::Mat> snapDocument(const cv::Mat& image, bool returnColor, int rotationAngle,
+                                    SnapWorkspace& workspace) {
+    SnapResult result = snapDocumentDetailed(image, returnColor, rotationAngle, {}, workspace);
+    if (!result.detection.found)
+        return std::nullopt;
+    return result.image;
 }
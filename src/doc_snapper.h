@@ -3,22 +3,156 @@
 
 #include <opencv2/opencv.hpp>
 #include <optional>
+#include <string>
+#include <utility>
+#include <vector>
 
 /**
- * Snap a photographed document to a top‑down, perspective‑corrected view.
+ * Wall-clock duration of each detection/warp stage, in milliseconds, summed
+ * over every detection width tried.
+ */
+struct SnapStageTimings {
+    double resizeMs{0.0};
+    double edgesMs{0.0};       // gray + blur + Canny
+    double contoursMs{0.0};
+    double quadSearchMs{0.0};  // approxPolyDP loop
+    double refineMs{0.0};      // cornerSubPix
+    double warpMs{0.0};        // warpPerspective (+ binarization); 0 for detection only
+
+    double totalMs() const;
+};
+
+/** Everything the detector found out about one image, successful or not. */
+struct DocumentDetection {
+    bool found{false};
+    std::string failureReason;          // empty on success
+    std::vector<cv::Point2f> corners;   // refined TL, TR, BR, BL in input coordinates
+    double scale{1.0};                  // input width / width of the detection pass that won
+    double areaFraction{0.0};           // quad area / image area
+    double angleRegularity{0.0};        // 1 = all interior angles 90 degrees, 0 = degenerate
+    double confidence{0.0};             // 0..1, combines area and angle regularity
+    SnapStageTimings timings;
+};
+
+/** Tuning knobs for the detector; the defaults suit photographed pages. */
+struct DetectionOptions {
+    // Use RETR_EXTERNAL and skip contours nested inside others. Much faster on
+    // cluttered backgrounds, but misses a page lying inside a closed outline
+    // (e.g. a tray or a desk edge that frames it).
+    bool externalContoursOnly{false};
+    // Drop contours whose bounding box covers less of the frame. Only a noise
+    // cutoff: it sits well below the smallest pages photographed in practice
+    // (about 1% of the frame), and maxQuadCandidates bounds the work anyway.
+    double minCandidateBoxFraction{0.002};
+    int maxQuadCandidates{5};              // fit polygons only to this many of the largest contours
+    // Detection widths tried coarse to fine. Each further width runs only
+    // while the best confidence so far is below escalateBelowConfidence; the
+    // most confident quad across all tried widths wins.
+    std::vector<int> detectionWidths{300, 600, 1200};
+    double escalateBelowConfidence{0.6};
+    bool autoCannyThresholds{true};  // derive Canny thresholds from the median intensity, not 75/200
+};
+
+/**
+ * Scratch buffers for the detection stages, kept alive between calls.
  *
- * @param image Input image containing a document (may be rotated, skewed, etc.)
- * @return An {@code std::optional<cv::Mat>} containing the processed image.
- *         If no document can be detected, the optional is empty.
+ * Give each worker thread its own workspace and pass it to every call. The
+ * image buffers are sized for the finest detection width once, and coarser
+ * widths work in views of the same storage. Once the buffers have grown to
+ * the sizes a batch needs, detection no longer allocates image or contour
+ * storage of its own; only the returned results and OpenCV's internal
+ * temporaries are allocated. Not thread-safe: never share one workspace
+ * between concurrent calls.
  */
+struct SnapWorkspace {
+    // Views into the buffers below (resized may also be the input itself)
+    cv::Mat resized;
+    cv::Mat gray;
+    cv::Mat blurred;
+    cv::Mat edged;
+    cv::Mat resizedBuffer;
+    cv::Mat grayBuffer;
+    cv::Mat blurredBuffer;
+    cv::Mat edgedBuffer;
+    // One list per detection width: cv::findContours resizes its output to
+    // the contour count, so widths sharing a list would free and reallocate
+    // contours whenever their counts differ
+    std::vector<std::vector<std::vector<cv::Point>>> contoursByWidth;
+    std::vector<std::pair<double, size_t>> candidates;  // (area, contour index)
+    std::vector<size_t> ranked;
+    std::vector<cv::Point> approx;
+    std::vector<cv::Point> quad;
+    cv::Mat coarsePatch;      // buffer for corner patches at the intermediate refinement scale
+    cv::Mat coarsePatchGray;
+    cv::Mat finePatchGray;    // buffer for gray corner patches at full resolution
+    std::vector<cv::Point2f> subPixPoint;
+};
+
+/** Result of snapDocumentDetailed(): the detection plus the warped page if found. */
+struct SnapResult {
+    DocumentDetection detection;
+    cv::Mat image;  // empty unless detection.found
+};
+
 /**
  * Snap a photographed document to a top-down, perspective-corrected view.
  *
- * @param image       Input image containing a document.
- * @param returnColor If true, returns the color-corrected image; if false, returns a B/W scanned look.
+ * @param image         Input image containing a document.
+ * @param returnColor   If true, returns the color-corrected image; if false, returns a B/W scanned look.
+ * @param rotationAngle Clockwise rotation (0, 90, 180, 270) folded into the perspective
+ *                      warp, so a rotated page costs no extra pass over the pixels.
  * @return An {@code std::optional<cv::Mat>} containing the processed image.
  *         If no document can be detected, the optional is empty.
  */
-std::optional<cv::Mat> snapDocument(const cv::Mat& image, bool returnColor = true);
+std::optional<cv::Mat> snapDocument(const cv::Mat& image, bool returnColor = true, int rotationAngle = 0);
+
+/** snapDocument() reusing a caller-owned workspace; see SnapWorkspace. */
+std::optional<cv::Mat> snapDocument(const cv::Mat& image, bool returnColor, int rotationAngle,
+                                    SnapWorkspace& workspace);
+
+/**
+ * Detect the document quad and report corners, confidence, scale and stage timings.
+ *
+ * @param image   Input image containing a document.
+ * @param options Contour search settings.
+ * @return The detection; check {@code found} and {@code failureReason}.
+ */
+DocumentDetection detectDocument(const cv::Mat& image, const DetectionOptions& options = {});
+
+/** detectDocument() reusing a caller-owned workspace; see SnapWorkspace. */
+DocumentDetection detectDocument(const cv::Mat& image, const DetectionOptions& options,
+                                 SnapWorkspace& workspace);
+
+/**
+ * Like snapDocument(), but also returns the full detection result so callers
+ * can route low-confidence pages to review or log timings.
+ */
+SnapResult snapDocumentDetailed(const cv::Mat& image, bool returnColor = true, int rotationAngle = 0,
+                                const DetectionOptions& options = {});
+
+/** snapDocumentDetailed() reusing a caller-owned workspace; see SnapWorkspace. */
+SnapResult snapDocumentDetailed(const cv::Mat& image, bool returnColor, int rotationAngle,
+                                const DetectionOptions& options, SnapWorkspace& workspace);
+
+/**
+ * Detect the document quad and refine its corners to subpixel accuracy.
+ *
+ * @param image Input image containing a document.
+ * @return Corners in {@code image} coordinates ordered TL, TR, BR, BL, or empty if
+ *         no document can be detected. Reuse them with warpDocument() to re-crop
+ *         the same page (e.g. at a new rotation) without running detection again.
+ */
+std::optional<std::vector<cv::Point2f>> detectDocumentCorners(const cv::Mat& image);
+
+/**
+ * Perspective-correct a page from previously detected corners.
+ *
+ * @param image         The image the corners were detected on.
+ * @param corners       Four corners ordered TL, TR, BR, BL.
+ * @param returnColor   If true, returns the color-corrected image; if false, returns a B/W scanned look.
+ * @param rotationAngle Clockwise rotation (0, 90, 180, 270) folded into the warp.
+ */
+cv::Mat warpDocument(const cv::Mat& image, const std::vector<cv::Point2f>& corners,
+                     bool returnColor = true, int rotationAngle = 0);
 
 #endif // DOC_SNAPPER_H
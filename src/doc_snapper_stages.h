@@ -0,0 +1,73 @@
+#ifndef DOC_SNAPPER_STAGES_H
+#define DOC_SNAPPER_STAGES_H
+
+// Individual stages of snapDocument(), exposed so the benchmark suite can time
+// each one in isolation. snapDocument() is simply these stages run in order.
+// Overloads taking a SnapWorkspace keep their scratch buffers in it; the
+// others use a temporary workspace.
+
+#include "doc_snapper.h"
+#include <opencv2/core.hpp>
+#include <vector>
+
+// Default width the detection stages run at; contours are scaled back by the returned ratio.
+constexpr int kDetectionWidth = 600;
+
+/**
+ * Downsample to `width` (never upscale; narrower images are used as-is).
+ * @return original-to-resized scale ratio.
+ */
+double resizeForDetection(const cv::Mat& image, cv::Mat& resized, int width = kDetectionWidth);
+double resizeForDetection(const cv::Mat& image, int width, SnapWorkspace& workspace);  // into workspace.resized
+
+/**
+ * Gray, blur and Canny edge-detect the downsampled image. With
+ * autoThresholds the hysteresis thresholds bracket the median intensity
+ * (0.67x and 1.33x), otherwise the fixed 75/200 pair is used.
+ */
+void detectEdges(const cv::Mat& resized, cv::Mat& edged, bool autoThresholds = true);
+void detectEdges(const cv::Mat& resized, cv::Mat& edged, bool autoThresholds, SnapWorkspace& workspace);
+
+/** Extract contours from an edge map; outermost ones only if externalOnly. */
+void findDocumentContours(const cv::Mat& edged, std::vector<std::vector<cv::Point>>& contours,
+                          bool externalOnly = false);
+
+/**
+ * Indices of the contours worth fitting a polygon to, largest area first:
+ * contours whose bounding box covers less than minCandidateBoxFraction of
+ * the frame are dropped, and at most maxQuadCandidates are returned.
+ */
+std::vector<size_t> rankQuadCandidates(const std::vector<std::vector<cv::Point>>& contours,
+                                       cv::Size frameSize, const DetectionOptions& options = {});
+void rankQuadCandidates(const std::vector<std::vector<cv::Point>>& contours, cv::Size frameSize,
+                        const DetectionOptions& options, SnapWorkspace& workspace);  // into workspace.ranked
+
+/**
+ * Pick the largest convex quadrilateral among the ranked candidates.
+ * @return empty if none qualifies.
+ */
+std::vector<cv::Point> selectDocumentQuad(const std::vector<std::vector<cv::Point>>& contours,
+                                          cv::Size frameSize, const DetectionOptions& options = {});
+void selectDocumentQuad(const std::vector<std::vector<cv::Point>>& contours, cv::Size frameSize,
+                        const DetectionOptions& options, SnapWorkspace& workspace);  // into workspace.quad
+
+/**
+ * Scale a detected quad back to full resolution, order it TL, TR, BR, BL and
+ * refine each corner to subpixel accuracy, first at an intermediate scale and
+ * then at full resolution. Only small patches around the corners are read
+ * and converted to gray.
+ */
+std::vector<cv::Point2f> refineCorners(const cv::Mat& image, const std::vector<cv::Point>& quad, double ratio);
+std::vector<cv::Point2f> refineCorners(const cv::Mat& image, const std::vector<cv::Point>& quad, double ratio,
+                                       SnapWorkspace& workspace);
+
+/**
+ * Warp the region bounded by ordered corners (TL, TR, BR, BL) to a top-down
+ * rectangle, rotated clockwise by rotationAngle (0, 90, 180, 270) in the same pass.
+ */
+cv::Mat fourPointTransform(const cv::Mat& image, const std::vector<cv::Point2f>& ordered, int rotationAngle = 0);
+
+/** Scanner-like B/W enhancement of a warped color page (Sauvola, DPI-scaled window). */
+cv::Mat binarizeScan(const cv::Mat& warped);
+
+#endif // DOC_SNAPPER_STAGES_H
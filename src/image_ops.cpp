@@ -0,0 +1,24 @@
+#include "image_ops.h"
+#include <opencv2/core.hpp>
+
+cv::Mat rotateImage(const cv::Mat& image, int angle) {
+    if (image.empty())
+        return image;
+
+    cv::Mat rotated;
+    switch (angle) {
+    case 90:
+        cv::rotate(image, rotated, cv::ROTATE_90_CLOCKWISE);
+        break;
+    case 180:
+        cv::rotate(image, rotated, cv::ROTATE_180);
+        break;
+    case 270:
+        cv::rotate(image, rotated, cv::ROTATE_90_COUNTERCLOCKWISE);
+        break;
+    default:
+        rotated = image;  // nothing to do; pixels are never modified in place
+        break;
+    }
+    return rotated;
+}
@@ -0,0 +1,15 @@
+#ifndef IMAGE_OPS_H
+#define IMAGE_OPS_H
+
+#include <opencv2/core.hpp>
+
+/**
+ * Rotate an image clockwise by a multiple of 90 degrees.
+ *
+ * @param image Input image.
+ * @param angle Clockwise rotation in degrees: 0, 90, 180 or 270. Other values are treated as 0.
+ * @return The rotated image. For angle 0 the input is returned as-is, sharing its pixels.
+ */
+cv::Mat rotateImage(const cv::Mat& image, int angle);
+
+#endif // IMAGE_OPS_H
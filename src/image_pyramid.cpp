@@ -0,0 +1,73 @@
+#include "image_pyramid.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+
+static cv::Mat downscaleToFit(const cv::Mat& source, int maxSide) {
+    const int longSide = std::max(source.cols, source.rows);
+    if (source.empty() || longSide <= maxSide)
+        return source;  // share pixels, never upscale
+    const double scale = static_cast<double>(maxSide) / longSide;
+    cv::Mat scaled;
+    cv::resize(source, scaled,
+               cv::Size(std::max(1, static_cast<int>(source.cols * scale + 0.5)),
+                        std::max(1, static_cast<int>(source.rows * scale + 0.5))),
+               0, 0, cv::INTER_AREA);
+    return scaled;
+}
+
+void ImagePyramid::reset(const cv::Mat& base) {
+    full = base;
+    preview.release();
+    thumbnail.release();
+}
+
+void ImagePyramid::adoptLevels(const cv::Mat& previewLevel, const cv::Mat& thumbnailLevel) {
+    full.release();
+    preview = previewLevel;
+    thumbnail = thumbnailLevel.empty() ? downscaleToFit(previewLevel, kThumbnailSize) : thumbnailLevel;
+}
+
+void ImagePyramid::build() {
+    level(Level::Thumbnail);
+}
+
+void ImagePyramid::releaseLargeLevels() {
+    full.release();
+    preview.release();
+}
+
+size_t ImagePyramid::derivedBytes() const {
+    size_t bytes = 0;
+    if (!preview.empty() && preview.datastart != full.datastart)
+        bytes += preview.total() * preview.elemSize();
+    if (!thumbnail.empty() && thumbnail.datastart != preview.datastart && thumbnail.datastart != full.datastart)
+        bytes += thumbnail.total() * thumbnail.elemSize();
+    return bytes;
+}
+
+const cv::Mat& ImagePyramid::level(Level which) {
+    switch (which) {
+    case Level::Thumbnail:
+        if (thumbnail.empty() && !full.empty())
+            thumbnail = downscaleToFit(level(Level::Preview), kThumbnailSize);
+        return thumbnail;
+    case Level::Preview:
+        if (preview.empty() && !full.empty())
+            preview = downscaleToFit(full, kPreviewSize);
+        return preview;
+    case Level::Full:
+    default:
+        return full;
+    }
+}
+
+const cv::Mat& ImagePyramid::levelFor(int maxWidth, int maxHeight) {
+    const int target = std::max(maxWidth, maxHeight);
+    if (full.empty() && !preview.empty() && target > kThumbnailSize)
+        return preview;  // adopted levels only
+    if (target <= kThumbnailSize || full.empty())
+        return level(Level::Thumbnail);
+    if (target <= kPreviewSize)
+        return level(Level::Preview);
+    return level(Level::Full);
+}
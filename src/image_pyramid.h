@@ -0,0 +1,68 @@
+#ifndef IMAGE_PYRAMID_H
+#define IMAGE_PYRAMID_H
+
+#include <opencv2/core.hpp>
+#include <cstddef>
+
+/**
+ * Downscaled renditions of one page image, built lazily on first access.
+ *
+ * Levels only ever shrink the base image: each one is derived from the next
+ * larger level with INTER_AREA, and a level that would not be smaller than
+ * its parent simply shares the parent's pixels. Call reset() whenever the
+ * base image changes; that drops every cached level.
+ */
+class ImagePyramid {
+public:
+    enum class Level {
+        Thumbnail,  // fits kThumbnailSize, for thumbnail strips
+        Preview,    // fits kPreviewSize, for the preview pane
+        Full        // the base image itself
+    };
+
+    static constexpr int kThumbnailSize = 120;
+    static constexpr int kPreviewSize = 2048;
+
+    ImagePyramid() = default;
+    explicit ImagePyramid(const cv::Mat& base) { reset(base); }
+
+    /** Replace the base image and invalidate all derived levels. */
+    void reset(const cv::Mat& base);
+
+    /**
+     * Show previously rendered levels (e.g. from a saved session) without a
+     * base image, as if the page had been evicted: empty() stays true until
+     * reset() supplies the full pixels.
+     */
+    void adoptLevels(const cv::Mat& previewLevel, const cv::Mat& thumbnailLevel);
+
+    /** Eagerly build every level, e.g. on a worker thread before handing over. */
+    void build();
+
+    /**
+     * Drop the base image and preview level but keep the thumbnail, so a
+     * page whose pixels were evicted can still be drawn in a thumbnail list.
+     */
+    void releaseLargeLevels();
+
+    /** Bytes held by levels that do not share the base image's pixels. */
+    size_t derivedBytes() const;
+
+    bool empty() const { return full.empty(); }
+
+    /** Pixels for a level, building it (and any parent level) if needed. */
+    const cv::Mat& level(Level which);
+
+    /**
+     * Smallest level that still covers a maxWidth x maxHeight viewport, or
+     * the largest level left if the base image has been released.
+     */
+    const cv::Mat& levelFor(int maxWidth, int maxHeight);
+
+private:
+    cv::Mat full;
+    cv::Mat preview;
+    cv::Mat thumbnail;
+};
+
+#endif // IMAGE_PYRAMID_H
@@ -0,0 +1,156 @@
+#include "Logger.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+
+namespace {
+
+constexpr size_t kRingSlots = 4096;  // power of two
+static_assert((kRingSlots & (kRingSlots - 1)) == 0, "ring size must be a power of two");
+
+/**
+ * Bounded multi-producer, single-consumer ring of formatted lines.
+ *
+ * Producers claim a slot with one compare-and-swap on the tail and publish
+ * it through the slot's sequence number (Vyukov's bounded queue); a full
+ * ring rejects the line instead of waiting. One writer thread drains it to
+ * stdout/stderr and flushes whenever it runs dry, so a burst of lines costs
+ * one flush rather than one per line.
+ */
+class AsyncSink {
+public:
+    AsyncSink() {
+        for (size_t i = 0; i < kRingSlots; ++i)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        writer = std::thread([this]() { run(); });
+    }
+
+    ~AsyncSink() {
+        stopping.store(true, std::memory_order_release);
+        wake();
+        writer.join();
+    }
+
+    void push(LogLevel level, std::string& line) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots[pos & (kRingSlots - 1)];
+            const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.level = level;
+                    slot.line.swap(line);
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    wake();
+                    return;
+                }
+            } else if (diff < 0) {
+                dropped.fetch_add(1, std::memory_order_relaxed);  // full: never block the caller
+                return;
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void flush() {
+        const size_t target = tail.load(std::memory_order_acquire);
+        while (written.load(std::memory_order_acquire) < target) {
+            wake();
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        LogLevel level{LogLevel::INFO};
+        std::string line;
+    };
+
+    void wake() {
+        pending.fetch_add(1, std::memory_order_release);
+        pending.notify_one();
+    }
+
+    void run() {
+        for (;;) {
+            const uint32_t seen = pending.load(std::memory_order_acquire);
+            if (drain())
+                continue;
+            if (const size_t lost = dropped.exchange(0, std::memory_order_relaxed))
+                std::fprintf(stderr, "[WARN] Logger: dropped %zu line(s), ring buffer full\n", lost);
+            std::fflush(stdout);
+            std::fflush(stderr);
+            if (stopping.load(std::memory_order_acquire)) {
+                if (!drain())
+                    return;
+                continue;
+            }
+            pending.wait(seen, std::memory_order_acquire);
+        }
+    }
+
+    // Write every published line; returns false if there was none
+    bool drain() {
+        bool any = false;
+        for (;;) {
+            const size_t pos = head;
+            Slot& slot = slots[pos & (kRingSlots - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != pos + 1)
+                return any;
+            std::FILE* out = slot.level >= LogLevel::WARN ? stderr : stdout;
+            std::fwrite(slot.line.data(), 1, slot.line.size(), out);
+            std::fputc('\n', out);
+            std::string().swap(slot.line);  // free here, not on the producer's thread
+            slot.sequence.store(pos + kRingSlots, std::memory_order_release);
+            head = pos + 1;
+            written.store(head, std::memory_order_release);
+            any = true;
+        }
+    }
+
+    std::array<Slot, kRingSlots> slots;
+    alignas(64) std::atomic<size_t> tail{0};
+    alignas(64) size_t head{0};  // writer thread only
+    std::atomic<size_t> written{0};
+    std::atomic<uint32_t> pending{0};
+    std::atomic<size_t> dropped{0};
+    std::atomic<bool> stopping{false};
+    std::thread writer;
+};
+
+// Set once the sink is destroyed at exit; later lines are written directly
+std::atomic<bool> sinkClosed{false};
+
+struct SinkHolder {
+    AsyncSink sink;
+    ~SinkHolder() { sinkClosed.store(true, std::memory_order_release); }
+};
+
+AsyncSink& sink() {
+    static SinkHolder holder;
+    return holder.sink;
+}
+
+} // namespace
+
+void Logger::write(LogLevel level, std::string line) {
+    if (sinkClosed.load(std::memory_order_acquire)) {
+        std::FILE* out = level >= LogLevel::WARN ? stderr : stdout;
+        std::fprintf(out, "%s\n", line.c_str());
+        return;
+    }
+    sink().push(level, line);
+}
+
+void Logger::flush() {
+    if (!sinkClosed.load(std::memory_order_acquire))
+        sink().flush();
+    std::fflush(stdout);
+    std::fflush(stderr);
+}
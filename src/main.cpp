@@ -3,10 +3,12 @@
 #include <QCoreApplication>
 #include <QDebug>
 #include "mainwindow.h"
+#include "trace.h"
 
 int main(int argc, char *argv[])
 {
     QApplication app(argc, argv);
+    setTraceThreadName("GUI");
     // Load and apply QDarkStyleSheet
     {
         const QString qssPath = QCoreApplication::applicationDirPath() + "/darkstyle.qss";
@@ -1,6 +1,11 @@
 #include "mainwindow.h"
-#include "doc_snapper.h"
 #include "export_dialog.h"
+#include "cv_qt_bridge.h"
+#include "image_ops.h"
+#include "pdf_writer.h"
+#include "doc_snapper.h"
+#include "trace.h"
+#include "Logger.hpp"
 #include <QApplication>
 #include <QFileDialog>
 #include <QMessageBox>
@@ -8,6 +13,7 @@
 #include <QHBoxLayout>
 #include <QPixmap>
 #include <QScrollArea>
+#include <QScrollBar>
 #include <QGridLayout>
 #include <QStyle>
 #include <QString>
@@ -16,275 +22,21 @@
 #include <QDrag>
 #include <QMimeData>
 #include <QMouseEvent>
-#include <QPrinter>
-#include <QPainter>
-#include <QPageSize>
-
-// Implementation of ThumbnailWidget
-ThumbnailWidget::ThumbnailWidget(ImageProcessingState *state, QWidget *parent)
-    : QWidget(parent), imageState(state), thumbnailLabel(nullptr)
-{
-    setAcceptDrops(true);
-
-    const int thumbnailSize = 120;
-
-    QVBoxLayout *mainLayout = new QVBoxLayout(this);
-    mainLayout->setSpacing(4);
-    mainLayout->setContentsMargins(4, 4, 4, 4);
-    mainLayout->setAlignment(Qt::AlignHCenter | Qt::AlignTop);
-
-    // Thumbnail image (clickable)
-    thumbnailLabel = new QLabel(this);
-    thumbnailLabel->setAlignment(Qt::AlignCenter);
-    thumbnailLabel->setFrameStyle(QFrame::Box | QFrame::Plain);
-    thumbnailLabel->setLineWidth(2);
-    thumbnailLabel->setStyleSheet("QLabel { border: 2px solid #555; }");
-    thumbnailLabel->setCursor(Qt::PointingHandCursor);
-    thumbnailLabel->setFixedSize(thumbnailSize, thumbnailSize);
-    thumbnailLabel->setScaledContents(false);
-
-    updateThumbnailImage();
-    mainLayout->addWidget(thumbnailLabel, 0, Qt::AlignHCenter);
-
-    // Control buttons row
-    QHBoxLayout *controlsLayout = new QHBoxLayout();
-    controlsLayout->setSpacing(4);
-    controlsLayout->setContentsMargins(0, 0, 0, 0);
-
-    // Rotate left button
-    QToolButton *rotateLeftBtn = new QToolButton(this);
-    rotateLeftBtn->setIcon(style()->standardIcon(QStyle::SP_ArrowBack));
-    rotateLeftBtn->setToolTip(tr("Rotate Left"));
-    rotateLeftBtn->setIconSize(QSize(20, 20));
-    connect(rotateLeftBtn, &QToolButton::clicked, this, &ThumbnailWidget::onRotateLeft);
-
-    // Rotate right button
-    QToolButton *rotateRightBtn = new QToolButton(this);
-    rotateRightBtn->setIcon(style()->standardIcon(QStyle::SP_ArrowForward));
-    rotateRightBtn->setToolTip(tr("Rotate Right"));
-    rotateRightBtn->setIconSize(QSize(20, 20));
-    connect(rotateRightBtn, &QToolButton::clicked, this, &ThumbnailWidget::onRotateRight);
-
-    // Snap button
-    QToolButton *snapBtn = new QToolButton(this);
-    snapBtn->setIcon(style()->standardIcon(QStyle::SP_FileDialogContentsView));
-    snapBtn->setToolTip(tr("Snap Document"));
-    snapBtn->setIconSize(QSize(20, 20));
-    connect(snapBtn, &QToolButton::clicked, this, &ThumbnailWidget::onSnap);
-
-    controlsLayout->addWidget(rotateLeftBtn);
-    controlsLayout->addWidget(rotateRightBtn);
-    controlsLayout->addWidget(snapBtn);
-
-    // Center the buttons horizontally
-    QHBoxLayout *buttonContainerLayout = new QHBoxLayout();
-    buttonContainerLayout->addStretch();
-    buttonContainerLayout->addLayout(controlsLayout);
-    buttonContainerLayout->addStretch();
-
-    mainLayout->addLayout(buttonContainerLayout, 0);
-}
-
-void ThumbnailWidget::updateThumbnailImage()
-{
-    if (!thumbnailLabel || !imageState)
-        return;
-
-    const int thumbnailSize = 120;
-    QImage qimg = cvMatToQImage(imageState->currentImage);
-    thumbnailLabel->setPixmap(QPixmap::fromImage(qimg).scaled(
-        thumbnailSize, thumbnailSize, Qt::KeepAspectRatio, Qt::SmoothTransformation));
-}
-
-QImage ThumbnailWidget::cvMatToQImage(const cv::Mat &mat)
-{
-    // Convert based on mat type
-    if (mat.empty())
-        return QImage();
-    switch (mat.type()) {
-    case CV_8UC1: {
-        QImage img(mat.cols, mat.rows, QImage::Format_Grayscale8);
-        memcpy(img.bits(), mat.data, static_cast<size_t>(mat.total() * mat.elemSize()));
-        return img;
-    }
-    case CV_8UC3: {
-        cv::Mat rgb;
-        cv::cvtColor(mat, rgb, cv::COLOR_BGR2RGB);
-        QImage img(rgb.data, rgb.cols, rgb.rows, static_cast<int>(rgb.step), QImage::Format_RGB888);
-        return img.copy(); // deep copy because cv::Mat will be freed
-    }
-    case CV_8UC4: {
-        QImage img(mat.data, mat.cols, mat.rows, static_cast<int>(mat.step), QImage::Format_ARGB32);
-        return img.copy();
-    }
-    default:
-        // Unsupported format
-        return QImage();
-    }
-}
-
-void ThumbnailWidget::setSelected(bool selected)
-{
-    if (!thumbnailLabel)
-        return;
-
-    if (selected) {
-        thumbnailLabel->setStyleSheet("QLabel { border: 3px solid #3daee9; }");
-    } else {
-        thumbnailLabel->setStyleSheet("QLabel { border: 2px solid #555; }");
-    }
-}
-
-void ThumbnailWidget::mousePressEvent(QMouseEvent *event)
-{
-    if (event->button() == Qt::LeftButton) {
-        // Check if click is on the thumbnail label
-        if (thumbnailLabel && thumbnailLabel->geometry().contains(event->pos())) {
-            emit thumbnailClicked(this);
-        } else {
-            // Start potential drag operation
-            dragStartPosition = event->pos();
-        }
-    }
-    QWidget::mousePressEvent(event);
-}
-
-void ThumbnailWidget::mouseMoveEvent(QMouseEvent *event)
-{
-    if (!(event->buttons() & Qt::LeftButton))
-        return;
-    if ((event->pos() - dragStartPosition).manhattanLength() < QApplication::startDragDistance())
-        return;
-
-    // Start drag operation
-    QDrag *drag = new QDrag(this);
-    QMimeData *mimeData = new QMimeData;
-
-    // Store pointer to this widget in mime data (as string for compatibility)
-    mimeData->setText(QString::number(reinterpret_cast<qintptr>(this)));
-    drag->setMimeData(mimeData);
-
-    // Create a pixmap of the widget for drag visualization
-    QPixmap pixmap(size());
-    render(&pixmap);
-    drag->setPixmap(pixmap.scaled(pixmap.size() * 0.8, Qt::KeepAspectRatio, Qt::SmoothTransformation));
-    drag->setHotSpot(event->pos());
-
-    drag->exec(Qt::MoveAction);
-}
-
-void ThumbnailWidget::dragEnterEvent(QDragEnterEvent *event)
-{
-    if (event->mimeData()->hasText() && event->source() != this) {
-        event->acceptProposedAction();
-    }
-}
-
-void ThumbnailWidget::dragMoveEvent(QDragMoveEvent *event)
-{
-    if (event->mimeData()->hasText() && event->source() != this) {
-        event->acceptProposedAction();
-    }
-}
-
-void ThumbnailWidget::dropEvent(QDropEvent *event)
-{
-    if (event->mimeData()->hasText() && event->source() != this) {
-        ThumbnailWidget *fromWidget = reinterpret_cast<ThumbnailWidget*>(
-            event->mimeData()->text().toLongLong());
-        emit thumbnailReordered(fromWidget, this);
-        event->acceptProposedAction();
-    }
-}
-
-void ThumbnailWidget::onRotateLeft()
-{
-    if (!imageState)
-        return;
-
-    imageState->rotationAngle = (imageState->rotationAngle + 270) % 360;
-    imageState->currentImage = rotateImage(imageState->originalImage, imageState->rotationAngle);
-
-    // If image was snapped, need to re-snap the rotated image
-    if (imageState->isSnapped) {
-        auto resultOpt = snapDocument(imageState->currentImage, true);
-        if (resultOpt) {
-            imageState->currentImage = *resultOpt;
-        }
-    }
-
-    updateThumbnailImage();
-    emit imageModified(this);
-}
-
-void ThumbnailWidget::onRotateRight()
-{
-    if (!imageState)
-        return;
-
-    imageState->rotationAngle = (imageState->rotationAngle + 90) % 360;
-    imageState->currentImage = rotateImage(imageState->originalImage, imageState->rotationAngle);
-
-    // If image was snapped, need to re-snap the rotated image
-    if (imageState->isSnapped) {
-        auto resultOpt = snapDocument(imageState->currentImage, true);
-        if (resultOpt) {
-            imageState->currentImage = *resultOpt;
-        }
-    }
-
-    updateThumbnailImage();
-    emit imageModified(this);
-}
-
-void ThumbnailWidget::onSnap()
-{
-    if (!imageState)
-        return;
-
-    // Apply snapping to the rotated image
-    cv::Mat rotatedImage = rotateImage(imageState->originalImage, imageState->rotationAngle);
-    auto resultOpt = snapDocument(rotatedImage, true);
-
-    if (!resultOpt) {
-        QMessageBox::warning(this, tr("Processing Error"),
-            tr("Failed to detect document in image: %1").arg(imageState->filename));
-        return;
-    }
-
-    imageState->currentImage = *resultOpt;
-    imageState->isSnapped = true;
-    imageState->rotationAngle = 0;
-
-    updateThumbnailImage();
-    emit imageModified(this);
-}
-
-cv::Mat ThumbnailWidget::rotateImage(const cv::Mat &image, int angle)
-{
-    if (image.empty())
-        return image;
-
-    cv::Mat rotated;
-    switch (angle) {
-    case 0:
-        rotated = image.clone();
-        break;
-    case 90:
-        cv::rotate(image, rotated, cv::ROTATE_90_CLOCKWISE);
-        break;
-    case 180:
-        cv::rotate(image, rotated, cv::ROTATE_180);
-        break;
-    case 270:
-        cv::rotate(image, rotated, cv::ROTATE_90_COUNTERCLOCKWISE);
-        break;
-    default:
-        rotated = image.clone();
-        break;
-    }
-    return rotated;
-}
+#include <QFile>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+#include <QDir>
+#include <QProgressDialog>
+#include <QEventLoop>
+#include <QThreadPool>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <QTransform>
+#include <QFutureWatcher>
+#include <QImageReader>
+#include <QtConcurrent/QtConcurrentRun>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -362,6 +114,12 @@ MainWindow::MainWindow(QWidget *parent)
     stagingScrollArea->setFixedHeight(240);
     mainLayout->addWidget(stagingScrollArea);
 
+    // Import progress, visible only while files are being decoded
+    importProgress = new QProgressBar(this);
+    importProgress->setTextVisible(true);
+    importProgress->hide();
+    mainLayout->addWidget(importProgress);
+
     QHBoxLayout *buttonLayout = new QHBoxLayout();
     QHBoxLayout *imageLayout = new QHBoxLayout();
 
@@ -379,6 +137,11 @@ MainWindow::MainWindow(QWidget *parent)
     processButton->setEnabled(false);
     buttonLayout->addWidget(nextButton);
     connect(nextButton, &QPushButton::clicked, this, &MainWindow::onNextClicked);
+    // Reopen the pages and edits left when the processing view was last closed
+    resumeButton = new QPushButton(tr("Resume Last Session"), this);
+    resumeButton->setIcon(style()->standardIcon(QStyle::SP_BrowserReload));
+    buttonLayout->addWidget(resumeButton);
+    connect(resumeButton, &QPushButton::clicked, this, &MainWindow::onResumeClicked);
     buttonLayout->addWidget(rotateLeftButton);
     buttonLayout->addWidget(rotateRightButton);
     buttonLayout->addWidget(processButton);
@@ -390,11 +153,18 @@ MainWindow::MainWindow(QWidget *parent)
     backButton = new QPushButton(tr("Back"), this);
     backButton->setIcon(style()->standardIcon(QStyle::SP_ArrowBack));
 
+    // Speculative snapping of every page; the revert button undoes it per page
+    autoSnapCheckBox = new QCheckBox(tr("Auto-snap pages"), this);
+    autoSnapCheckBox->setChecked(true);
+    autoSnapCheckBox->setToolTip(tr("Detect and snap documents on all pages in the background"));
+
     // Initialize hints
     hints.push_back(tr("Tip: Hold and drag thumbnails to rearrange images"));
     hints.push_back(tr("Tip: Click a thumbnail to preview the image"));
     hints.push_back(tr("Tip: Use the rotate buttons below each thumbnail"));
     hints.push_back(tr("Tip: Click the snap button to auto-detect documents"));
+    hints.push_back(tr("Tip: Pages are snapped in the background; the revert button restores the original"));
+    hints.push_back(tr("Tip: Scroll over the preview to zoom, drag to pan, double-click for 1:1"));
     // Detect OS for keyboard shortcut hint
 #ifdef Q_OS_MACOS
     hints.push_back(tr("Tip: Press Cmd+U to upload more images"));
@@ -414,6 +184,7 @@ MainWindow::MainWindow(QWidget *parent)
     hintTimer = new QTimer(this);
     connect(hintTimer, &QTimer::timeout, this, &MainWindow::rotateHint);
 
+    buttonLayout->addWidget(autoSnapCheckBox);
     buttonLayout->addWidget(backButton);
     buttonLayout->addWidget(exportButton);
 
@@ -424,29 +195,35 @@ MainWindow::MainWindow(QWidget *parent)
     QHBoxLayout *processingLayout = new QHBoxLayout(processingView);
     processingLayout->setContentsMargins(0, 0, 0, 0);
 
-    // Left column (1 part): Thumbnail list
-    thumbnailScrollArea = new QScrollArea(processingView);
-    thumbnailContainer = new QWidget(thumbnailScrollArea);
-    thumbnailLayout = new QVBoxLayout(thumbnailContainer);
-    thumbnailLayout->setAlignment(Qt::AlignTop);
-    thumbnailContainer->setLayout(thumbnailLayout);
-    thumbnailScrollArea->setWidget(thumbnailContainer);
-    thumbnailScrollArea->setWidgetResizable(true);
-    thumbnailScrollArea->setMinimumWidth(200);
-    thumbnailScrollArea->setMaximumWidth(300);
+    // Left column (1 part): Thumbnail list; only visible rows are painted
+    pageModel = new PageListModel(this);
+    pageModel->setPageStore(&pageStore);
+    thumbnailView = new PageListView(processingView);
+    auto *pageDelegate = new PageItemDelegate(thumbnailView);
+    thumbnailView->setModel(pageModel);
+    thumbnailView->setItemDelegate(pageDelegate);
+    thumbnailView->setMinimumWidth(200);
+    thumbnailView->setMaximumWidth(300);
+    connect(pageDelegate, &PageItemDelegate::actionTriggered, pageModel, &PageListModel::triggerAction);
+    connect(pageModel, &PageListModel::pageModified, this, &MainWindow::onPageModified);
+    connect(thumbnailView->selectionModel(), &QItemSelectionModel::currentChanged,
+            this, &MainWindow::onCurrentPageChanged);
+    // Pages scrolled into view are the likeliest to be opened next
+    connect(thumbnailView->verticalScrollBar(), &QScrollBar::valueChanged,
+            this, &MainWindow::touchVisiblePages);
+    autoSnap = new AutoSnapScheduler(pageModel, this);
+    connect(thumbnailView->verticalScrollBar(), &QScrollBar::valueChanged,
+            this, &MainWindow::updateAutoSnapFocus);
+    connect(autoSnapCheckBox, &QCheckBox::toggled, this, &MainWindow::onAutoSnapToggled);
 
     // Right column (3 parts): Preview
-    previewScrollArea = new QScrollArea(processingView);
-    previewLabel = new QLabel(previewScrollArea);
-    previewLabel->setAlignment(Qt::AlignCenter);
-    previewLabel->setText(tr("Select an image to preview"));
-    previewLabel->setMinimumSize(400, 400);
-    previewScrollArea->setWidget(previewLabel);
-    previewScrollArea->setWidgetResizable(true);
+    previewView = new PageView(processingView);
+    previewView->setMinimumSize(400, 400);
+    previewView->showMessage(tr("Select an image to preview"));
 
     // Add to processing layout with 1:3 ratio
-    processingLayout->addWidget(thumbnailScrollArea, 1);
-    processingLayout->addWidget(previewScrollArea, 3);
+    processingLayout->addWidget(thumbnailView, 1);
+    processingLayout->addWidget(previewView, 3);
 
     mainLayout->addWidget(processingView);
     mainLayout->addWidget(hintLabel);
@@ -468,11 +245,13 @@ MainWindow::MainWindow(QWidget *parent)
 
     // Initial view: only show drop zone (next button shown when images are staged)
     nextButton->hide();
+    resumeButton->setVisible(QFileInfo::exists(sessionPath()));
     processButton->hide();
     rotateLeftButton->hide();
     rotateRightButton->hide();
     exportButton->hide();
     backButton->hide();
+    autoSnapCheckBox->hide();
     stagingScrollArea->hide();
     processingView->hide();
 }
@@ -500,22 +279,52 @@ void MainWindow::onUploadClicked()
     onFilesDropped(fileNames);
 }
 
+namespace {
+const int kStagingThumbWidth = 150;
+const int kStagingThumbHeight = 150;
+
+// Pick the coarsest decoder-level reduction that still leaves comfortably
+// more pixels than a staging tile. JPEG decoders scale in the DCT domain, so
+// this skips most of the decode work; full resolution is loaded lazily later.
+int stagingDecodeFlags(const QString &fileName)
+{
+    const QSize fullSize = QImageReader(fileName).size();  // header only
+    if (!fullSize.isValid())
+        return cv::IMREAD_COLOR;
+    const int longSide = std::max(fullSize.width(), fullSize.height());
+    const int minLongSide = 2 * std::max(kStagingThumbWidth, kStagingThumbHeight);
+    if (longSide / 8 >= minLongSide)
+        return cv::IMREAD_REDUCED_COLOR_8;
+    if (longSide / 4 >= minLongSide)
+        return cv::IMREAD_REDUCED_COLOR_4;
+    if (longSide / 2 >= minLongSide)
+        return cv::IMREAD_REDUCED_COLOR_2;
+    return cv::IMREAD_COLOR;
+}
+
+// Decode result handed back from the import workers
+struct StagedDecode {
+    PageBuffer image;
+    QImage thumbnail;  // already downscaled so the GUI thread only wraps it in a pixmap
+};
+} // namespace
+
 // Handle files dropped or selected for staging
 void MainWindow::onFilesDropped(const QStringList &fileNames)
 {
     if (fileNames.isEmpty())
         return;
+    TraceSpan span("onFilesDropped");
     // Add new files to staging without clearing previous
-    const int thumbnailWidth = 150;
-    const int thumbnailHeight = 150;
+    const int thumbnailWidth = kStagingThumbWidth;
+    const int thumbnailHeight = kStagingThumbHeight;
     for (const QString &fileName : fileNames) {
         // Skip duplicates
         if (std::find(stagedFilenames.begin(), stagedFilenames.end(), fileName) != stagedFilenames.end())
             continue;
-        cv::Mat img = cv::imread(fileName.toStdString(), cv::IMREAD_COLOR);
-        if (img.empty())
-            continue;
-        stagedImages.push_back(img);
+        // Reserve the slot now so drop order is kept however decodes finish;
+        // an empty Mat marks an import still in flight.
+        stagedImages.push_back(PageBuffer());
         stagedFilenames.push_back(fileName);
         // Create thumbnail and delete icon (vertical layout)
         QWidget *itemWidget = new QWidget(this);
@@ -524,9 +333,7 @@ void MainWindow::onFilesDropped(const QStringList &fileNames)
         itemLayout->setContentsMargins(4, 4, 4, 4);
         itemLayout->setSpacing(4);
 
-        QImage qimg = cvMatToQImage(img);
-        QLabel *thumb = new QLabel(itemWidget);
-        thumb->setPixmap(QPixmap::fromImage(qimg).scaled(thumbnailWidth - 8, thumbnailHeight, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+        QLabel *thumb = new QLabel(tr("Loading..."), itemWidget);
         thumb->setAlignment(Qt::AlignCenter);
         thumb->setFixedHeight(thumbnailHeight);
         itemLayout->addWidget(thumb, 0);  // Don't stretch
@@ -549,60 +356,94 @@ void MainWindow::onFilesDropped(const QStringList &fileNames)
         stagingWidgets.push_back(itemWidget);
         // Connect removal
         connect(deleteButton, &QToolButton::clicked, this, [this, itemWidget]() {
+            removeStagingItem(itemWidget);
+        });
+
+        // Decode on the thread pool; the watcher dies with the tile, so a
+        // tile removed mid-decode simply never receives its result.
+        auto *watcher = new QFutureWatcher<StagedDecode>(itemWidget);
+        connect(watcher, &QFutureWatcher<StagedDecode>::finished, this,
+                [this, watcher, itemWidget, thumb]() {
+            const StagedDecode result = watcher->result();
             auto it = std::find(stagingWidgets.begin(), stagingWidgets.end(), itemWidget);
-            if (it != stagingWidgets.end()) {
-                int idx = std::distance(stagingWidgets.begin(), it);
-                stagingWidgets.erase(it);
-                stagedImages.erase(stagedImages.begin() + idx);
-                stagedFilenames.erase(stagedFilenames.begin() + idx);
-                stagingLayout->removeWidget(itemWidget);
-                delete itemWidget;
-                // Hide staging area and next button if no files remain
-                if (stagedImages.empty()) {
-                    stagingScrollArea->hide();
-                    nextButton->hide();
-                }
+            if (it == stagingWidgets.end())
+                return;
+            if (result.image.empty()) {
+                // Undecodable file: drop its tile (counts as a finished import)
+                removeStagingItem(itemWidget);
+                return;
             }
+            stagedImages[std::distance(stagingWidgets.begin(), it)] = result.image;
+            thumb->setPixmap(QPixmap::fromImage(result.thumbnail));
+            ++importDone;
+            updateImportProgress();
         });
+        const int slot = static_cast<int>(stagedImages.size()) - 1;
+        watcher->setFuture(QtConcurrent::run([fileName, slot]() {
+            TraceSpan span("stagingDecode", slot);
+            StagedDecode result;
+            result.image = PageBuffer::decode(fileName.toStdString(), stagingDecodeFlags(fileName));
+            if (result.image.empty())
+                return result;
+            const double scale = std::min(static_cast<double>(kStagingThumbWidth - 8) / result.image.width(),
+                                          static_cast<double>(kStagingThumbHeight) / result.image.height());
+            cv::Mat small;
+            cv::resize(result.image.pixels(), small, cv::Size(), scale, scale, cv::INTER_AREA);
+            result.thumbnail = matToQImage(small);
+            return result;
+        }));
+        ++importTotal;
+    }
+    updateImportProgress();
+}
+
+// Remove a staging tile and its slot in the staged vectors
+void MainWindow::removeStagingItem(QWidget *itemWidget)
+{
+    auto it = std::find(stagingWidgets.begin(), stagingWidgets.end(), itemWidget);
+    if (it == stagingWidgets.end())
+        return;
+    int idx = std::distance(stagingWidgets.begin(), it);
+    // Removing a tile that is still loading counts as that import finishing
+    if (stagedImages[idx].empty())
+        ++importDone;
+    stagingWidgets.erase(it);
+    stagedImages.erase(stagedImages.begin() + idx);
+    stagedFilenames.erase(stagedFilenames.begin() + idx);
+    stagingLayout->removeWidget(itemWidget);
+    // Deferred: this may run from a signal of one of the tile's children
+    itemWidget->hide();
+    itemWidget->deleteLater();
+    updateImportProgress();
+}
+
+// Reflect outstanding imports in the progress bar and staging controls
+void MainWindow::updateImportProgress()
+{
+    const bool importing = importDone < importTotal;
+    if (importing) {
+        importProgress->setMaximum(importTotal);
+        importProgress->setValue(importDone);
+        importProgress->setFormat(tr("Importing %1 of %2...").arg(importDone).arg(importTotal));
+        importProgress->show();
+    } else {
+        // Batch finished; start counting afresh for the next drop
+        importProgress->hide();
+        importDone = 0;
+        importTotal = 0;
     }
+
     // Show or hide staging area and next button based on whether we have images
     if (!stagedImages.empty()) {
         stagingScrollArea->show();
         nextButton->show();
+        nextButton->setEnabled(!importing);
     } else {
         stagingScrollArea->hide();
         nextButton->hide();
     }
 }
 
-// Reorder thumbnails when drag and drop occurs
-void MainWindow::reorderThumbnails(ThumbnailWidget *fromWidget, ThumbnailWidget *toWidget)
-{
-    if (!fromWidget || !toWidget || fromWidget == toWidget)
-        return;
-
-    int fromIndex = getThumbnailIndex(fromWidget);
-    int toIndex = getThumbnailIndex(toWidget);
-
-    if (fromIndex < 0 || toIndex < 0)
-        return;
-
-    // Reorder thumbnailWidgets vector (widgets maintain their state references)
-    thumbnailWidgets.erase(thumbnailWidgets.begin() + fromIndex);
-    thumbnailWidgets.insert(thumbnailWidgets.begin() + toIndex, fromWidget);
-
-    // Update layout to reflect new order
-    for (ThumbnailWidget *widget : thumbnailWidgets) {
-        thumbnailLayout->removeWidget(widget);
-    }
-    for (ThumbnailWidget *widget : thumbnailWidgets) {
-        thumbnailLayout->addWidget(widget);
-    }
-
-    // Note: We don't reorder processingStates because each widget has a direct pointer to its state
-    // The state order doesn't matter for saving since we iterate through thumbnailWidgets
-}
-
 // Transition from staging to processing view
 void MainWindow::onNextClicked()
 {
@@ -610,42 +451,108 @@ void MainWindow::onNextClicked()
         QMessageBox::information(this, tr("No Images"), tr("Please add images before proceeding."));
         return;
     }
+    if (importDone < importTotal) {
+        QMessageBox::information(this, tr("Import In Progress"), tr("Please wait for all images to finish loading."));
+        return;
+    }
 
     // Initialize processing states from staged images
+    pageModel->clear();
+    currentPage = nullptr;
+    pageStore.clear();
     processingStates.clear();
     for (size_t i = 0; i < stagedImages.size(); ++i) {
         ImageProcessingState state;
-        state.originalImage = stagedImages[i].clone();
-        state.currentImage = stagedImages[i].clone();
+        // Staged images are reduced decodes; full pixels load on first use
+        state.previewImage = stagedImages[i];
+        state.pyramid.reset(state.previewImage.pixels());
         state.filename = stagedFilenames[i];
-        state.rotationAngle = 0;
-        state.isSnapped = false;
+        state.editCache = std::make_shared<EditCache>();
         processingStates.push_back(state);
     }
+    openSession.reset();
+
+    showProcessingView();
+}
 
-    // Clear old thumbnails
-    for (ThumbnailWidget *widget : thumbnailWidgets) {
-        thumbnailLayout->removeWidget(widget);
-        delete widget;
+// Resume the pages saved by saveSession(). Pages show their stored display
+// levels straight from the mapped file; full pixels and edit steps are
+// re-evaluated from the sources as pages are opened.
+void MainWindow::onResumeClicked()
+{
+    TraceSpan span("resumeSession");
+    std::shared_ptr<const SessionFile> session = SessionFile::open(QFile::encodeName(sessionPath()).toStdString());
+    if (!session || session->pages().empty()) {
+        QMessageBox::warning(this, tr("Resume Failed"), tr("The last session could not be opened."));
+        resumeButton->hide();
+        return;
     }
-    thumbnailWidgets.clear();
 
-    // Create thumbnail widgets - each manages its own state
-    for (size_t i = 0; i < processingStates.size(); ++i) {
-        ThumbnailWidget *thumbWidget = new ThumbnailWidget(&processingStates[i], thumbnailContainer);
+    pageModel->clear();
+    currentPage = nullptr;
+    pageStore.clear();
+    processingStates.clear();
+    QStringList missing;
+    int changed = 0;
+    for (const SessionPage &page : session->pages()) {
+        ImageProcessingState state;
+        state.filename = QString::fromStdString(page.sourcePath);
+        if (!QFileInfo::exists(state.filename)) {
+            missing << QFileInfo(state.filename).fileName();
+            continue;
+        }
+        state.editCache = std::make_shared<EditCache>();
+        if (sourceUnchanged(page.sourcePath, page.source)) {
+            for (const EditOp &op : page.edits)
+                state.edits.push(op);
+            state.displaySteps = page.appliedSteps;
+            state.autoSnapTried = page.autoSnapTried;
+            state.pyramid.adoptLevels(page.preview, page.thumbnail);
+            // Unedited levels double as the reduced decode for edit previews;
+            // copied so background jobs never hold pointers into the mapping
+            if (page.appliedSteps == 0)
+                state.previewImage = PageBuffer(page.preview.clone());
+        } else {
+            ++changed;  // the edits were made on other content; start the page afresh
+        }
+        processingStates.push_back(state);
+    }
+    if (processingStates.empty()) {
+        QMessageBox::warning(this, tr("Resume Failed"), tr("None of the session's images could be found."));
+        return;
+    }
+    openSession = session;
 
-        // Connect signals
-        connect(thumbWidget, &ThumbnailWidget::thumbnailClicked, this, &MainWindow::onThumbnailClicked);
-        connect(thumbWidget, &ThumbnailWidget::thumbnailReordered, this, &MainWindow::reorderThumbnails);
-        connect(thumbWidget, &ThumbnailWidget::imageModified, this, &MainWindow::onImageModified);
+    showProcessingView();
+    for (ImageProcessingState *state : pageModel->pages()) {
+        if (state->pyramid.level(ImagePyramid::Level::Thumbnail).empty())
+            pageModel->ensureLoaded(state);  // changed source: nothing stored to show
+    }
 
-        thumbnailLayout->addWidget(thumbWidget);
-        thumbnailWidgets.push_back(thumbWidget);
+    if (!missing.isEmpty() || changed > 0) {
+        QString message;
+        if (!missing.isEmpty())
+            message += tr("Skipped %n missing image(s): %1", nullptr, missing.size()).arg(missing.join(", ")) + "\n";
+        if (changed > 0)
+            message += tr("%n image(s) changed on disk since the session was saved; their edits were reset.", nullptr, changed);
+        QMessageBox::information(this, tr("Session Resumed"), message.trimmed());
     }
+}
+
+// List processingStates in the thumbnail strip and switch to the processing view
+void MainWindow::showProcessingView()
+{
+    // The model holds pointers into processingStates, which no longer grows
+    std::vector<ImageProcessingState*> pages;
+    pages.reserve(processingStates.size());
+    for (ImageProcessingState &state : processingStates)
+        pages.push_back(&state);
+    pageModel->setPages(pages);
 
     // Switch visibility first
     dropZone->hide();
     nextButton->hide();
+    resumeButton->hide();
     stagingScrollArea->hide();
     processButton->hide();
     rotateLeftButton->hide();
@@ -653,14 +560,14 @@ void MainWindow::onNextClicked()
     backButton->show();
     exportButton->show();
     exportButton->setEnabled(true);
+    autoSnapCheckBox->show();
     processingView->show();
 
     // Select first image by default (after showing processingView so dimensions are correct)
-    if (!thumbnailWidgets.empty()) {
-        currentThumbnail = thumbnailWidgets[0];
-        currentThumbnail->setSelected(true);
-        updatePreview();
-    }
+    if (pageModel->rowCount() > 0)
+        thumbnailView->setCurrentIndex(pageModel->index(0));
+    if (autoSnapCheckBox->isChecked())
+        autoSnap->start();
 
     // Show hint label and start rotating hints
     hintLabel->show();
@@ -674,79 +581,27 @@ void MainWindow::onProcessClicked()
     // This function is no longer used in the new workflow
 }
 
-QImage MainWindow::cvMatToQImage(const cv::Mat &mat)
+// Preview the page selected in the thumbnail strip (click or keyboard)
+void MainWindow::onCurrentPageChanged(const QModelIndex &current)
 {
-    // Convert based on mat type
-    if (mat.empty())
-        return QImage();
-    switch (mat.type()) {
-    case CV_8UC1: {
-        QImage img(mat.cols, mat.rows, QImage::Format_Grayscale8);
-        memcpy(img.bits(), mat.data, static_cast<size_t>(mat.total() * mat.elemSize()));
-        return img;
-    }
-    case CV_8UC3: {
-        cv::Mat rgb;
-        cv::cvtColor(mat, rgb, cv::COLOR_BGR2RGB);
-        QImage img(rgb.data, rgb.cols, rgb.rows, static_cast<int>(rgb.step), QImage::Format_RGB888);
-        return img.copy(); // deep copy because cv::Mat will be freed
-    }
-    case CV_8UC4: {
-        QImage img(mat.data, mat.cols, mat.rows, static_cast<int>(mat.step), QImage::Format_ARGB32);
-        return img.copy();
-    }
-    default:
-        // Unsupported format
-        return QImage();
-    }
-}
-
-cv::Mat MainWindow::qImageToCvMat(const QImage &image)
-{
-    switch (image.format()) {
-    case QImage::Format_Grayscale8: {
-        cv::Mat mat(image.height(), image.width(), CV_8UC1, const_cast<uchar*>(image.bits()), static_cast<size_t>(image.bytesPerLine()));
-        return mat.clone();
-    }
-    case QImage::Format_RGB888: {
-        cv::Mat mat(image.height(), image.width(), CV_8UC3, const_cast<uchar*>(image.bits()), static_cast<size_t>(image.bytesPerLine()));
-        cv::Mat bgr;
-        cv::cvtColor(mat, bgr, cv::COLOR_RGB2BGR);
-        return bgr.clone();
-    }
-    case QImage::Format_ARGB32: {
-        cv::Mat mat(image.height(), image.width(), CV_8UC4, const_cast<uchar*>(image.bits()), static_cast<size_t>(image.bytesPerLine()));
-        return mat.clone();
-    }
-    default:
-        return cv::Mat();
-    }
-}
-
-// Handle thumbnail click to select and preview an image
-void MainWindow::onThumbnailClicked(ThumbnailWidget *widget)
-{
-    if (!widget)
-        return;
-
-    // Deselect previous thumbnail
-    if (currentThumbnail) {
-        currentThumbnail->setSelected(false);
-    }
-
-    // Select new thumbnail
-    currentThumbnail = widget;
-    currentThumbnail->setSelected(true);
-
-    // Update preview
+    currentPage = pageModel->page(current.row());
+    updateAutoSnapFocus();
     updatePreview();
 }
 
 // Handle image modification (rotation, snapping, etc.)
-void MainWindow::onImageModified(ThumbnailWidget *widget)
+void MainWindow::onPageModified(ImageProcessingState *state)
 {
+    // Newly produced pixels may push the batch over its memory budget
+    if (state) {
+        pageStore.touch(state);
+        if (currentPage && currentPage != state)
+            pageStore.touch(currentPage);  // never evict the page on screen
+        pageStore.enforceBudget();
+    }
+
     // Update preview if this is the currently selected image
-    if (widget == currentThumbnail) {
+    if (state == currentPage) {
         updatePreview();
     }
 }
@@ -754,41 +609,54 @@ void MainWindow::onImageModified(ThumbnailWidget *widget)
 // Update the preview pane with the currently selected image
 void MainWindow::updatePreview()
 {
-    if (!currentThumbnail) {
-        previewLabel->setText(tr("Select an image to preview"));
-        previewLabel->setPixmap(QPixmap());
-        return;
-    }
-
-    const ImageProcessingState *state = currentThumbnail->getState();
+    ImageProcessingState *state = currentPage;
     if (!state) {
-        previewLabel->setText(tr("Select an image to preview"));
-        previewLabel->setPixmap(QPixmap());
+        previewView->showMessage(tr("Select an image to preview"));
         return;
     }
 
-    const QImage qimg = cvMatToQImage(state->currentImage);
+    TraceSpan span("updatePreview", traceEnabled() ? pageModel->rowOf(state) : -1);
+    if (state->currentImage.empty()) {
+        // Show the reduced decode (or the thumbnail of an evicted page)
+        // straight away and sharpen once loaded
+        pageModel->ensureLoaded(state);
+    }
+    pageStore.touch(state);
 
-    // Scale to fit preview area while maintaining aspect ratio
-    const int maxWidth = previewScrollArea->width() - 20;
-    const int maxHeight = previewScrollArea->height() - 20;
+    // The preview level is shown as is; zooming in past it switches to tiles
+    // cut from the full level in the background
+    previewView->setPage(state, state->pyramid.level(ImagePyramid::Level::Full),
+                         state->pyramid.levelFor(ImagePyramid::kPreviewSize, ImagePyramid::kPreviewSize),
+                         state->viewRotation());
+}
 
-    QPixmap pixmap = QPixmap::fromImage(qimg);
-    if (pixmap.width() > maxWidth || pixmap.height() > maxHeight) {
-        pixmap = pixmap.scaled(maxWidth, maxHeight, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-    }
+// Refresh the page store's recency for thumbnails currently in view
+void MainWindow::touchVisiblePages()
+{
+    const auto [first, last] = thumbnailView->visibleRows();
+    for (int row = first; row >= 0 && row <= last; ++row)
+        pageStore.touch(pageModel->page(row));
+    if (currentPage)
+        pageStore.touch(currentPage);
+}
 
-    previewLabel->setPixmap(pixmap);
-    previewLabel->setText(QString());
+// Let the auto-snap scheduler favor the page on screen and the rows in view
+void MainWindow::updateAutoSnapFocus()
+{
+    const auto [first, last] = thumbnailView->visibleRows();
+    autoSnap->setFocus(currentPage, first, last);
 }
 
-// Get the index of a thumbnail widget in the thumbnailWidgets vector
-int MainWindow::getThumbnailIndex(ThumbnailWidget *widget) const
+void MainWindow::onAutoSnapToggled(bool enabled)
 {
-    auto it = std::find(thumbnailWidgets.begin(), thumbnailWidgets.end(), widget);
-    if (it == thumbnailWidgets.end())
-        return -1;
-    return static_cast<int>(std::distance(thumbnailWidgets.begin(), it));
+    if (!processingView->isVisible())
+        return;  // applies from the next time pages are opened
+    if (enabled) {
+        updateAutoSnapFocus();
+        autoSnap->start();
+    } else {
+        autoSnap->stop();
+    }
 }
 
 // Rotate through the hint messages
@@ -806,8 +674,9 @@ void MainWindow::onBackClicked()
 {
     // Show confirmation dialog
     QMessageBox::StandardButton reply = QMessageBox::question(this,
-        tr("Discard Changes?"),
-        tr("Going back will discard all changes (rotations, snapping, etc.).\n\nAre you sure you want to continue?"),
+        tr("Close Pages?"),
+        tr("Going back will close these pages. Their edits (rotations, snapping, etc.) are saved "
+           "and can be reopened with Resume Last Session.\n\nAre you sure you want to continue?"),
         QMessageBox::Yes | QMessageBox::No,
         QMessageBox::No);
 
@@ -815,6 +684,9 @@ void MainWindow::onBackClicked()
         return;
     }
 
+    saveSession();
+    autoSnap->stop();
+
     // Stop hint timer
     hintTimer->stop();
 
@@ -822,30 +694,71 @@ void MainWindow::onBackClicked()
     processingView->hide();
     backButton->hide();
     exportButton->hide();
+    autoSnapCheckBox->hide();
     hintLabel->hide();
 
     // Show upload view
     dropZone->show();
+    resumeButton->setVisible(QFileInfo::exists(sessionPath()));
     if (!stagedImages.empty()) {
         stagingScrollArea->show();
         nextButton->show();
     }
 
     // Clear current thumbnail selection
-    if (currentThumbnail) {
-        currentThumbnail->setSelected(false);
-        currentThumbnail = nullptr;
+    thumbnailView->selectionModel()->clear();
+    currentPage = nullptr;
+}
+
+// Save open pages so the next run can resume them
+void MainWindow::closeEvent(QCloseEvent *event)
+{
+    if (processingView->isVisible())
+        saveSession();
+    QMainWindow::closeEvent(event);
+}
+
+QString MainWindow::sessionPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + QStringLiteral("/last-session.pxs");
+}
+
+// Write every page, in display order, to the session file. Only display
+// levels are stored: sources are fingerprinted, not copied, and the edit
+// list reproduces full-resolution pixels on demand.
+void MainWindow::saveSession()
+{
+    if (pageModel->pages().empty())
+        return;
+    TraceSpan span("saveSession");
+    std::vector<SessionPage> pages;
+    pages.reserve(pageModel->pages().size());
+    for (ImageProcessingState *state : pageModel->pages()) {
+        SessionPage page;
+        page.sourcePath = state->filename.toStdString();
+        page.source = fingerprintFile(page.sourcePath);
+        page.edits = state->edits.ops();
+        page.appliedSteps = state->displaySteps;
+        page.autoSnapTried = state->autoSnapTried;
+        page.thumbnail = state->pyramid.level(ImagePyramid::Level::Thumbnail);
+        page.preview = state->pyramid.level(ImagePyramid::Level::Preview);
+        pages.push_back(std::move(page));
     }
+
+    const QString path = sessionPath();
+    if (!QDir().mkpath(QFileInfo(path).absolutePath())
+            || !writeSession(QFile::encodeName(path).toStdString(), pages))
+        Logger::warn("MainWindow: session not saved to ", path.toStdString());
 }
 
 // Handle export button click
 void MainWindow::onExportClicked()
 {
-    if (thumbnailWidgets.empty())
+    if (pageModel->pages().empty())
         return;
 
     // Show export dialog
-    ExportDialog dialog(static_cast<int>(thumbnailWidgets.size()), this);
+    ExportDialog dialog(pageModel->rowCount(), this);
     if (dialog.exec() != QDialog::Accepted)
         return;
 
@@ -887,30 +800,153 @@ void MainWindow::onExportClicked()
     }
 }
 
+// Edit steps after the first `baked`
+static std::vector<EditOp> remainingEdits(const ImageProcessingState &state, size_t baked)
+{
+    const std::vector<EditOp> &ops = state.edits.ops();
+    return std::vector<EditOp>(ops.begin() + static_cast<std::ptrdiff_t>(std::min(baked, ops.size())), ops.end());
+}
+
+// Full-resolution pixels for export; pages never opened or evicted by the
+// page store are reloaded on the spot without caching, so exporting a large
+// batch stays memory-flat. This is the only place pending steps such as a
+// trailing rotation are materialized.
+cv::Mat MainWindow::exportImage(const ImageProcessingState &state)
+{
+    if (!state.currentImage.empty()) {
+        const std::vector<EditOp> rest = remainingEdits(state, state.appliedSteps);
+        return evaluateEdits(state.currentImage.pixels(), rest, rest.size()).image;
+    }
+
+    if (!state.spillPath.isEmpty()) {
+        const cv::Mat spilled = cv::imread(QFile::encodeName(state.spillPath).toStdString(), cv::IMREAD_UNCHANGED);
+        if (!spilled.empty() && state.spillHash == state.edits.prefixHash(state.appliedSteps)) {
+            const std::vector<EditOp> rest = remainingEdits(state, state.appliedSteps);
+            return evaluateEdits(spilled, rest, rest.size()).image;
+        }
+    }
+    // Nothing is baked into a reloaded original, so apply every step
+    const cv::Mat original = cv::imread(state.filename.toStdString(), cv::IMREAD_COLOR);
+    if (original.empty())
+        return original;
+    return evaluateEdits(original, state.edits.ops(), state.edits.size()).image;
+}
+
+// Materialize, encode and write one page; runs on a worker thread
+static bool exportPageToFile(const ImageProcessingState &page, const QString &outPath,
+                             const std::string &extension, const std::atomic<bool> &cancelled,
+                             int pageIndex)
+{
+    TraceSpan span("exportPage", pageIndex);
+    if (cancelled.load())
+        return false;
+    const cv::Mat pixels = MainWindow::exportImage(page);
+    if (pixels.empty() || cancelled.load())
+        return false;
+
+    std::vector<uchar> encoded;
+    try {
+        if (!cv::imencode(extension, pixels, encoded))
+            return false;
+    } catch (const cv::Exception &) {
+        return false;
+    }
+
+    QSaveFile file(outPath);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    const qint64 size = static_cast<qint64>(encoded.size());
+    if (file.write(reinterpret_cast<const char *>(encoded.data()), size) != size)
+        return false;
+    return file.commit();
+}
+
 // Export all images to a directory
 void MainWindow::exportToImages(const QString &directory, const QString &format)
 {
+    // Snapshot page order and parameters; workers only ever see these copies
+    std::vector<ImageProcessingState> pages;
+    pages.reserve(pageModel->pages().size());
+    for (const ImageProcessingState *state : pageModel->pages())
+        pages.push_back(*state);
+    const int total = static_cast<int>(pages.size());
+    if (total == 0)
+        return;
+    TraceSpan span("exportToImages");
+
+    // Names depend only on the page order, never on completion order. Pages
+    // sharing a base name (from different folders) would race to write one
+    // file, so later ones get a "_2", "_3"... suffix.
+    std::vector<QString> outPaths;
+    outPaths.reserve(pages.size());
+    QSet<QString> taken;
+    for (const ImageProcessingState &page : pages) {
+        const QString base = QFileInfo(page.filename).completeBaseName() + "_processed";
+        QString name = base;
+        for (int n = 2; taken.contains(name.toLower()); ++n)
+            name = base + QStringLiteral("_%1").arg(n);
+        taken.insert(name.toLower());
+        outPaths.push_back(directory + "/" + name + "." + format);
+    }
+
+    QProgressDialog progress(tr("Exporting images..."), tr("Cancel"), 0, total, this);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(0);
+    progress.setValue(0);
+
+    // At most one page per pool thread is decoded/encoded at a time, which
+    // caps memory at a few pages no matter how large the batch is.
+    const int maxInFlight = std::max(1, QThreadPool::globalInstance()->maxThreadCount());
+    const std::string extension = "." + format.toStdString();
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    int nextPage = 0;
+    int inFlight = 0;
+    int finished = 0;
     int successCount = 0;
     int failCount = 0;
-
-    for (size_t i = 0; i < thumbnailWidgets.size(); ++i) {
-        const ImageProcessingState *state = thumbnailWidgets[i]->getState();
-        if (!state)
-            continue;
-
-        QImage qimg = cvMatToQImage(state->currentImage);
-        QString base = QFileInfo(state->filename).completeBaseName();
-        QString outPath = directory + "/" + base + "_processed." + format;
-
-        if (qimg.save(outPath)) {
-            successCount++;
-        } else {
-            failCount++;
+    QEventLoop loop;
+
+    std::function<void()> submitMore = [&]() {
+        while (!cancelled->load() && inFlight < maxInFlight && nextPage < total) {
+            const int pageIndex = nextPage++;
+            const ImageProcessingState &page = pages[pageIndex];
+            const QString &outPath = outPaths[pageIndex];
+
+            auto *watcher = new QFutureWatcher<bool>(&loop);
+            connect(watcher, &QFutureWatcher<bool>::finished, &loop, [&, watcher]() {
+                watcher->deleteLater();
+                --inFlight;
+                ++finished;
+                if (watcher->result())
+                    ++successCount;
+                else if (!cancelled->load())
+                    ++failCount;
+                if (!cancelled->load())
+                    progress.setValue(finished);
+                submitMore();
+                if (inFlight == 0)
+                    loop.quit();
+            });
+            ++inFlight;
+            watcher->setFuture(QtConcurrent::run([page, outPath, extension, cancelled, pageIndex]() {
+                return exportPageToFile(page, outPath, extension, *cancelled, pageIndex);
+            }));
         }
-    }
+    };
+    connect(&progress, &QProgressDialog::canceled, &loop, [&]() {
+        cancelled->store(true);
+    });
+
+    submitMore();
+    if (inFlight > 0)
+        loop.exec();
+    progress.reset();
 
     // Show result message
-    if (failCount == 0) {
+    if (cancelled->load()) {
+        QMessageBox::information(this, tr("Export Cancelled"),
+            tr("Export cancelled after %1 image(s).").arg(successCount));
+    } else if (failCount == 0) {
         QMessageBox::information(this, tr("Export Complete"),
             tr("Successfully exported %1 image(s) to:\n%2").arg(successCount).arg(directory));
     } else {
@@ -923,57 +959,76 @@ void MainWindow::exportToImages(const QString &directory, const QString &format)
 // Export all images to a single PDF file
 void MainWindow::exportToPdf(const QString &filePath)
 {
-    if (thumbnailWidgets.empty())
+    if (pageModel->pages().empty())
         return;
+    TraceSpan span("exportToPdf");
+
+    // Pages are streamed to disk one at a time; nothing is rasterized by Qt.
+    // They go to a temporary file next to the target, which only replaces
+    // it once the PDF is complete, so a failed export leaves no broken file.
+    const QString partialPath = filePath + QStringLiteral(".part");
+    PdfWriter writer;
+    if (!writer.open(QFile::encodeName(partialPath).toStdString())) {
+        QMessageBox::warning(this, tr("Export Error"),
+            tr("Failed to create PDF file: %1").arg(filePath));
+        return;
+    }
 
-    QPrinter printer(QPrinter::HighResolution);
-    printer.setOutputFormat(QPrinter::PdfFormat);
-    printer.setOutputFileName(filePath);
-
-    QPainter painter;
-    bool firstPage = true;
-
-    for (size_t i = 0; i < thumbnailWidgets.size(); ++i) {
-        const ImageProcessingState *state = thumbnailWidgets[i]->getState();
-        if (!state)
-            continue;
-
-        QImage qimg = cvMatToQImage(state->currentImage);
-        if (qimg.isNull())
-            continue;
-
-        // Set page size to match image dimensions (in points, 72 DPI)
-        // Convert pixel dimensions to points (1 point = 1/72 inch)
-        const double dpi = 300.0;  // Assume 300 DPI for image
-        const double pointsPerPixel = 72.0 / dpi;
-        const QSizeF pageSize(qimg.width() * pointsPerPixel, qimg.height() * pointsPerPixel);
-        printer.setPageSize(QPageSize(pageSize, QPageSize::Point));
+    // Page size is derived from pixel dimensions (1 point = 1/72 inch)
+    const double dpi = 300.0;  // Assume 300 DPI for image
+
+    const std::vector<ImageProcessingState*> &pages = pageModel->pages();
+    QStringList skipped;  // pages that could not be loaded, by number
+    for (size_t i = 0; i < pages.size(); ++i) {
+        const ImageProcessingState *state = pages[i];
+        TraceSpan pageSpan("exportPage", static_cast<int>(i));
+
+        // Untouched JPEG pages are embedded byte-for-byte without decoding
+        bool written = false;
+        const QString suffix = QFileInfo(state->filename).suffix().toLower();
+        if (state->edits.empty() && (suffix == "jpg" || suffix == "jpeg")) {
+            QFile source(state->filename);
+            if (source.open(QIODevice::ReadOnly)) {
+                const QByteArray bytes = source.readAll();
+                const std::vector<unsigned char> jpeg(bytes.cbegin(), bytes.cend());
+                written = writer.addJpegPassthroughPage(jpeg, dpi);
+            }
+        }
 
-        // Start painter on first page or add new page
-        if (firstPage) {
-            if (!painter.begin(&printer)) {
-                QMessageBox::warning(this, tr("Export Error"),
-                    tr("Failed to create PDF file: %1").arg(filePath));
-                return;
+        if (!written) {
+            const cv::Mat pixels = exportImage(*state);
+            if (pixels.empty()) {
+                Logger::warn("MainWindow: page ", i + 1, " left out of PDF; cannot load ",
+                             state->filename.toStdString());
+                skipped << QStringLiteral("%1 (%2)").arg(i + 1).arg(QFileInfo(state->filename).fileName());
+                continue;
             }
-            firstPage = false;
-        } else {
-            if (!printer.newPage()) {
+            if (!writer.addImagePage(pixels, dpi)) {
+                writer.close();
+                QFile::remove(partialPath);
                 QMessageBox::warning(this, tr("Export Error"),
                     tr("Failed to add page %1 to PDF").arg(i + 1));
-                painter.end();
                 return;
             }
         }
-
-        // Get page rect and draw image to fill entire page
-        QRect pageRect = printer.pageRect(QPrinter::DevicePixel).toRect();
-        painter.drawImage(pageRect, qimg);
     }
 
-    painter.end();
+    if (!writer.close()
+            || (QFile::exists(filePath) && !QFile::remove(filePath))
+            || !QFile::rename(partialPath, filePath)) {
+        QFile::remove(partialPath);
+        QMessageBox::warning(this, tr("Export Error"),
+            tr("Failed to write PDF file: %1").arg(filePath));
+        return;
+    }
 
-    QMessageBox::information(this, tr("Export Complete"),
-        tr("Successfully exported %1 image(s) to PDF:\n%2")
-        .arg(thumbnailWidgets.size()).arg(filePath));
+    if (skipped.isEmpty()) {
+        QMessageBox::information(this, tr("Export Complete"),
+            tr("Successfully exported %1 image(s) to PDF:\n%2")
+            .arg(writer.pageCount()).arg(filePath));
+    } else {
+        QMessageBox::warning(this, tr("Export Completed with Errors"),
+            tr("Exported %1 image(s) to PDF:\n%2\n\nThese pages could not be loaded and were left out:\n%3")
+            .arg(writer.pageCount()).arg(filePath).arg(skipped.join(", ")));
+    }
 }
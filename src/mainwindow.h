@@ -15,6 +15,7 @@
 #include <QString>
 #include <QFileInfo>
 #include <vector>
+#include <memory>
 #include <opencv2/opencv.hpp>
 #include <optional>
 #include <QUrl>
@@ -26,6 +27,15 @@
 #include <QTimer>
 #include <QShortcut>
 #include <QKeySequence>
+#include <QProgressBar>
+#include <QCloseEvent>
+#include <QCheckBox>
+#include "auto_snap.h"
+#include "page_list.h"
+#include "page_state.h"
+#include "page_store.h"
+#include "page_view.h"
+#include "session_file.h"
 
 // Widget to accept drag-and-drop of image files
 class DropFrame : public QFrame {
@@ -61,70 +71,21 @@ protected:
     }
 };
 
-// Forward declarations
-class MainWindow;
-class ThumbnailWidget;
-
-// Structure to track image processing state
-struct ImageProcessingState {
-    cv::Mat originalImage;
-    cv::Mat currentImage;
-    QString filename;
-    int rotationAngle{0};  // 0, 90, 180, 270
-    bool isSnapped{false};
-};
-
-// Self-contained thumbnail widget with encapsulated state and behavior
-class ThumbnailWidget : public QWidget {
-    Q_OBJECT
-public:
-    explicit ThumbnailWidget(ImageProcessingState *state, QWidget *parent = nullptr);
-
-    ImageProcessingState* getState() const { return imageState; }
-    void updateThumbnailImage();
-    void setSelected(bool selected);
-    static QImage cvMatToQImage(const cv::Mat &mat);
-
-signals:
-    void thumbnailClicked(ThumbnailWidget *widget);
-    void thumbnailReordered(ThumbnailWidget *fromWidget, ThumbnailWidget *toWidget);
-    void imageModified(ThumbnailWidget *widget);
-
-protected:
-    void mousePressEvent(QMouseEvent *event) override;
-    void mouseMoveEvent(QMouseEvent *event) override;
-    void dragEnterEvent(QDragEnterEvent *event) override;
-    void dragMoveEvent(QDragMoveEvent *event) override;
-    void dropEvent(QDropEvent *event) override;
-
-private slots:
-    void onRotateLeft();
-    void onRotateRight();
-    void onSnap();
-
-private:
-    ImageProcessingState *imageState;  // Non-owning pointer to state managed by MainWindow
-    QLabel *thumbnailLabel;
-    QPoint dragStartPosition;
-
-    cv::Mat rotateImage(const cv::Mat &image, int angle);
-};
-
-// Declare metatype for Qt signal/slot system
-Q_DECLARE_METATYPE(ThumbnailWidget*)
-
 class MainWindow : public QMainWindow {
     Q_OBJECT
 public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow() override = default;
 
-public slots:
-    void reorderThumbnails(ThumbnailWidget *fromWidget, ThumbnailWidget *toWidget);
+    // Full-resolution export pixels for a page; safe to call from worker threads
+    static cv::Mat exportImage(const ImageProcessingState &state);
+
+protected:
+    void closeEvent(QCloseEvent *event) override;
 
 private slots:
-    void onThumbnailClicked(ThumbnailWidget *widget);
-    void onImageModified(ThumbnailWidget *widget);
+    void onCurrentPageChanged(const QModelIndex &current);
+    void onPageModified(ImageProcessingState *state);
     void onUploadClicked();
     void onFilesDropped(const QStringList &files);
     void onProcessClicked();
@@ -132,7 +93,10 @@ private slots:
     void onRotateRightClicked();
     void onExportClicked();
     void onNextClicked();
+    void onResumeClicked();
     void onBackClicked();
+    void onAutoSnapToggled(bool enabled);
+    void updateAutoSnapFocus();
     void rotateHint();
 
 private:
@@ -142,6 +106,7 @@ private:
     QPushButton *rotateRightButton{};
     QPushButton *exportButton{};
     QPushButton *backButton{};
+    QCheckBox *autoSnapCheckBox{};  // Snap all pages in the background while processing
     QLabel *hintLabel{};
     QTimer *hintTimer{};
     std::vector<QString> hints;
@@ -150,32 +115,42 @@ private:
     // Drop zone and staging view
     DropFrame *dropZone{};
     QPushButton *nextButton{};
+    QPushButton *resumeButton{};  // Shown while a saved session exists
     QScrollArea *stagingScrollArea{};
     QWidget *stagingContainer{};
     QHBoxLayout *stagingLayout{};
-    std::vector<cv::Mat> stagedImages;
+    std::vector<PageBuffer> stagedImages;
     std::vector<QString> stagedFilenames;
     // Corresponding staging item widgets for removal
     std::vector<QWidget*> stagingWidgets;
+    // Background import progress for the current batch of dropped files
+    QProgressBar *importProgress{};
+    int importTotal{0};
+    int importDone{0};
 
     // Processing view (1:3 column layout)
     QWidget *processingView{};
-    QScrollArea *thumbnailScrollArea{};
-    QWidget *thumbnailContainer{};
-    QVBoxLayout *thumbnailLayout{};
-    QLabel *previewLabel{};
-    QScrollArea *previewScrollArea{};
-    std::vector<ThumbnailWidget*> thumbnailWidgets;
-    ThumbnailWidget *currentThumbnail{nullptr};
+    PageListView *thumbnailView{};
+    PageListModel *pageModel{};  // Page order, per-page processing and row status
+    PageView *previewView{};
+    ImageProcessingState *currentPage{nullptr};
+    AutoSnapScheduler *autoSnap{};
 
     // Image processing state
     std::vector<ImageProcessingState> processingStates;
+    PageStore pageStore;  // Keeps resident page pixels within the memory budget
+    // Mapped session the states were resumed from; their adopted pyramid
+    // levels point into it, so it lives until the states are replaced
+    std::shared_ptr<const SessionFile> openSession;
 
     // Helper functions
-    static QImage cvMatToQImage(const cv::Mat &mat);
-    static cv::Mat qImageToCvMat(const QImage &image);
+    void showProcessingView();
     void updatePreview();
-    int getThumbnailIndex(ThumbnailWidget *widget) const;
+    void touchVisiblePages();
+    void removeStagingItem(QWidget *itemWidget);
+    void updateImportProgress();
     void exportToImages(const QString &directory, const QString &format);
     void exportToPdf(const QString &filePath);
+    static QString sessionPath();
+    void saveSession();
 };
@@ -0,0 +1,25 @@
+#include "page_buffer.h"
+#include <opencv2/imgcodecs.hpp>
+
+PageBuffer PageBuffer::decode(const std::string& path, int flags) {
+    return PageBuffer(cv::imread(path, flags));
+}
+
+size_t PageBuffer::byteSize() const {
+    return mat.empty() ? 0 : mat.total() * mat.elemSize();
+}
+
+bool PageBuffer::isShared() const {
+    // Pixels without UMatData are borrowed from elsewhere: treat as shared
+    return !mat.empty() && (!mat.u || mat.u->refcount > 1);
+}
+
+bool PageBuffer::sharesPixelsWith(const PageBuffer& other) const {
+    return !mat.empty() && mat.datastart == other.mat.datastart;
+}
+
+cv::Mat& PageBuffer::mutablePixels() {
+    if (isShared())
+        mat = mat.clone();
+    return mat;
+}
@@ -0,0 +1,55 @@
+#ifndef PAGE_BUFFER_H
+#define PAGE_BUFFER_H
+
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <string>
+
+/**
+ * Immutable, reference-counted page pixels.
+ *
+ * Copying a PageBuffer shares the pixel allocation; the only read access is
+ * through a const cv::Mat, so staging, original and current images of an
+ * untouched page are one allocation. Operations that produce new pixels
+ * (warp, rotate, decode) wrap their output in a new buffer; code that really
+ * must edit pixels calls mutablePixels(), which clones first if anyone else
+ * still references them.
+ */
+class PageBuffer {
+public:
+    PageBuffer() = default;
+
+    /**
+     * Adopt freshly produced pixels. The caller must not write to them
+     * through another cv::Mat header afterwards.
+     */
+    explicit PageBuffer(const cv::Mat& pixels) : mat(pixels) {}
+
+    /** Decode an image file; empty on failure. */
+    static PageBuffer decode(const std::string& path, int flags);
+
+    bool empty() const { return mat.empty(); }
+    int width() const { return mat.cols; }
+    int height() const { return mat.rows; }
+
+    /** Read-only view of the pixels. */
+    const cv::Mat& pixels() const { return mat; }
+
+    /** Size of the pixel data in bytes (not counting other references). */
+    size_t byteSize() const;
+
+    /** True if another buffer or cv::Mat header references the same pixels. */
+    bool isShared() const;
+
+    bool sharesPixelsWith(const PageBuffer& other) const;
+
+    /** Writable pixels, cloned first if they are shared (copy-on-write). */
+    cv::Mat& mutablePixels();
+
+    void release() { mat.release(); }
+
+private:
+    cv::Mat mat;
+};
+
+#endif // PAGE_BUFFER_H
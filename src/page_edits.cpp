@@ -0,0 +1,296 @@
+#include "page_edits.h"
+#include "doc_snapper.h"
+#include "image_ops.h"
+#include "trace.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+using namespace cv;
+using namespace std;
+
+namespace {
+
+constexpr uint64_t kFnvOffset = 1469598103934665603ull;
+constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+// FNV-1a over the value's bytes; only used with padding-free scalars
+template <typename T>
+uint64_t mix(uint64_t hash, const T& value) {
+    static_assert(is_trivially_copyable_v<T>, "hash scalars only");
+    unsigned char bytes[sizeof(T)];
+    memcpy(bytes, &value, sizeof(T));
+    for (unsigned char b : bytes) {
+        hash ^= b;
+        hash *= kFnvPrime;
+    }
+    return hash;
+}
+
+// Apply one step in place; false if it could not be applied (no document
+// found, empty crop). Unresolved snap corners are filled in on success. A
+// snap also turns the page clockwise by `snapRotation` in the same warp.
+bool applyEdit(Mat& image, EditOp& op, int snapRotation = 0) {
+    switch (op.kind) {
+    case EditKind::Rotate:
+        image = rotateImage(image, op.angle);
+        return true;
+    case EditKind::Snap: {
+        Mat color = image;
+        if (image.channels() == 1)
+            cvtColor(image, color, COLOR_GRAY2BGR);  // detection expects BGR
+        const Point2f size(static_cast<float>(image.cols), static_cast<float>(image.rows));
+        if (op.corners.size() != 4) {
+            auto detected = detectDocumentCorners(color);
+            if (!detected)
+                return false;
+            op.corners.clear();
+            for (const Point2f& p : *detected)
+                op.corners.emplace_back(p.x / size.x, p.y / size.y);
+        }
+        vector<Point2f> corners;
+        corners.reserve(4);
+        for (const Point2f& p : op.corners)
+            corners.emplace_back(p.x * size.x, p.y * size.y);
+        image = warpDocument(color, corners, true, snapRotation);
+        return !image.empty();
+    }
+    case EditKind::Crop: {
+        const Rect rect = Rect(cvRound(op.crop.x * image.cols), cvRound(op.crop.y * image.rows),
+                               cvRound(op.crop.width * image.cols), cvRound(op.crop.height * image.rows))
+                        & Rect(0, 0, image.cols, image.rows);
+        if (rect.empty())
+            return false;
+        image = image(rect);  // shares pixels; results are read-only
+        return true;
+    }
+    case EditKind::Binarize: {
+        BinarizationParams params = op.binarization;
+        params.dpi = estimateScanDpi(image);
+        image = binarizeDocument(image, params);
+        return !image.empty();
+    }
+    case EditKind::ColorCorrect: {
+        Mat corrected;
+        image.convertTo(corrected, -1, op.gain, op.bias);
+        image = corrected;
+        return true;
+    }
+    }
+    return false;
+}
+
+} // namespace
+
+EditOp EditOp::rotate(int angle) {
+    EditOp op;
+    op.kind = EditKind::Rotate;
+    op.angle = ((angle % 360) + 360) % 360;
+    return op;
+}
+
+EditOp EditOp::snap(vector<Point2f> corners) {
+    EditOp op;
+    op.kind = EditKind::Snap;
+    op.corners = std::move(corners);
+    return op;
+}
+
+EditOp EditOp::cropTo(const Rect2f& crop) {
+    EditOp op;
+    op.kind = EditKind::Crop;
+    op.crop = crop;
+    return op;
+}
+
+EditOp EditOp::binarize(const BinarizationParams& params) {
+    EditOp op;
+    op.kind = EditKind::Binarize;
+    op.binarization = params;
+    return op;
+}
+
+EditOp EditOp::colorCorrect(double gain, double bias) {
+    EditOp op;
+    op.kind = EditKind::ColorCorrect;
+    op.gain = gain;
+    op.bias = bias;
+    return op;
+}
+
+uint64_t hashEditOp(uint64_t prefix, const EditOp& op) {
+    uint64_t h = mix(prefix, static_cast<int>(op.kind));
+    // Hash only the fields the kind uses, so defaults elsewhere never matter
+    switch (op.kind) {
+    case EditKind::Rotate:
+        h = mix(h, op.angle);
+        break;
+    case EditKind::Snap:
+        h = mix(h, static_cast<int>(op.corners.size()));
+        for (const Point2f& p : op.corners)
+            h = mix(mix(h, p.x), p.y);
+        break;
+    case EditKind::Crop:
+        h = mix(mix(mix(mix(h, op.crop.x), op.crop.y), op.crop.width), op.crop.height);
+        break;
+    case EditKind::Binarize:
+        h = mix(mix(mix(h, static_cast<int>(op.binarization.method)), op.binarization.k),
+                op.binarization.windowSize);
+        break;
+    case EditKind::ColorCorrect:
+        h = mix(mix(h, op.gain), op.bias);
+        break;
+    }
+    return h;
+}
+
+void PageEdits::rotate(int angle) {
+    const EditOp op = EditOp::rotate(angle);
+    if (op.angle == 0)
+        return;
+    if (!list.empty() && list.back().kind == EditKind::Rotate) {
+        list.back().angle = (list.back().angle + op.angle) % 360;
+        if (list.back().angle == 0)
+            list.pop_back();
+        return;
+    }
+    list.push_back(op);
+}
+
+void PageEdits::replacePrefix(size_t count, const vector<EditOp>& ops) {
+    list.erase(list.begin(), list.begin() + static_cast<ptrdiff_t>(min(count, list.size())));
+    list.insert(list.begin(), ops.begin(), ops.end());
+}
+
+bool PageEdits::contains(EditKind kind) const {
+    return any_of(list.begin(), list.end(), [kind](const EditOp& op) { return op.kind == kind; });
+}
+
+size_t PageEdits::displayLength() const {
+    size_t n = list.size();
+    while (n > 0 && list[n - 1].kind == EditKind::Rotate)
+        --n;
+    return n;
+}
+
+int PageEdits::trailingRotation() const {
+    int angle = 0;
+    for (size_t i = displayLength(); i < list.size(); ++i)
+        angle += list[i].angle;
+    return angle % 360;
+}
+
+uint64_t PageEdits::prefixHash(size_t count) const {
+    return hashEditPrefix(list, count);
+}
+
+uint64_t hashEditPrefix(const vector<EditOp>& ops, size_t count) {
+    uint64_t h = kFnvOffset;
+    for (size_t i = 0; i < min(count, ops.size()); ++i)
+        h = hashEditOp(h, ops[i]);
+    return h;
+}
+
+bool EditCache::find(uint64_t key, Mat& image) {
+    lock_guard<std::mutex> lock(mutex);
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it->key == key) {
+            entries.splice(entries.begin(), entries, it);
+            image = it->image;
+            return true;
+        }
+    }
+    return false;
+}
+
+void EditCache::insert(uint64_t key, const Mat& image) {
+    lock_guard<std::mutex> lock(mutex);
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it->key == key) {
+            bytes -= it->image.total() * it->image.elemSize();
+            entries.erase(it);
+            break;
+        }
+    }
+    entries.push_front({key, image});
+    bytes += image.total() * image.elemSize();
+    while (bytes > maxBytes && entries.size() > 1) {
+        bytes -= entries.back().image.total() * entries.back().image.elemSize();
+        entries.pop_back();
+    }
+}
+
+void EditCache::clear() {
+    lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    bytes = 0;
+}
+
+size_t EditCache::byteSize() const {
+    lock_guard<std::mutex> lock(mutex);
+    return bytes;
+}
+
+EditEvaluation evaluateEdits(const Mat& source, const vector<EditOp>& ops, size_t count, EditCache* cache) {
+    TraceSpan span("evaluateEdits");
+    EditEvaluation result;
+    count = min(count, ops.size());
+
+    // Cache keys cover the source size, so preview and full-resolution
+    // evaluations of the same list are memoized side by side
+    const uint64_t sourceKey = mix(mix(mix(kFnvOffset, source.cols), source.rows), source.type());
+    vector<uint64_t> keys;
+    keys.reserve(count);
+    uint64_t key = sourceKey;
+    for (size_t i = 0; i < count; ++i) {
+        if (ops[i].kind == EditKind::Snap && ops[i].corners.size() != 4)
+            break;  // output depends on detection: not known before evaluating
+        key = hashEditOp(key, ops[i]);
+        keys.push_back(key);
+    }
+
+    Mat image = source;
+    size_t start = 0;
+    if (cache) {
+        for (size_t k = keys.size(); k > 0; --k) {
+            if (cache->find(keys[k - 1], image)) {
+                start = k;
+                break;
+            }
+        }
+    }
+    result.cachedSteps = start;
+    result.resolved.assign(ops.begin(), ops.begin() + static_cast<ptrdiff_t>(start));
+    key = start > 0 ? keys[start - 1] : sourceKey;
+
+    for (size_t i = start; i < count && !image.empty(); ++i) {
+        EditOp op = ops[i];
+        // Rotations right after a snap ride along in its perspective warp
+        // instead of taking another pass over the pixels each
+        size_t folded = 0;
+        int foldedAngle = 0;
+        if (op.kind == EditKind::Snap) {
+            for (; i + 1 + folded < count && ops[i + 1 + folded].kind == EditKind::Rotate; ++folded)
+                foldedAngle += ops[i + 1 + folded].angle;
+        }
+        Mat output = image;
+        if (!applyEdit(output, op, foldedAngle % 360)) {
+            ++result.failedSteps;  // skipped: the list evaluates as if it were absent
+            continue;              // and the rotations run on their own
+        }
+        image = output;
+        key = hashEditOp(key, op);
+        result.resolved.push_back(std::move(op));
+        // The snapped image before the rotations is never made, so only the
+        // state after the last folded step is cached
+        for (; folded > 0; --folded) {
+            key = hashEditOp(key, ops[++i]);
+            result.resolved.push_back(ops[i]);
+        }
+        if (cache)
+            cache->insert(key, image);
+    }
+    result.image = image;
+    return result;
+}
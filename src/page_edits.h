@@ -0,0 +1,135 @@
+#ifndef PAGE_EDITS_H
+#define PAGE_EDITS_H
+
+#include "binarize.h"
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <vector>
+
+/** Kinds of non-destructive page edit, applied in list order. */
+enum class EditKind {
+    Rotate,        // clockwise quarter turns
+    Snap,          // perspective-correct the detected (or given) document quad
+    Crop,          // keep a rectangle of the input
+    Binarize,      // Sauvola/Wolf black-and-white conversion
+    ColorCorrect   // linear contrast/brightness: out = in * gain + bias
+};
+
+/**
+ * One edit step. Geometry is stored relative to the step's input size
+ * (x and y in [0, 1]), so the same list evaluates at any resolution: a
+ * reduced preview decode for display, the full image for export.
+ */
+struct EditOp {
+    EditKind kind{EditKind::Rotate};
+    int angle{0};                      // Rotate: 90, 180 or 270
+    std::vector<cv::Point2f> corners;  // Snap: normalized TL, TR, BR, BL; empty = detect on evaluation
+    cv::Rect2f crop;                   // Crop: normalized rectangle
+    BinarizationParams binarization;   // Binarize; dpi is re-estimated from the page
+    double gain{1.0};                  // ColorCorrect
+    double bias{0.0};                  // ColorCorrect
+
+    static EditOp rotate(int angle);
+    static EditOp snap(std::vector<cv::Point2f> corners = {});
+    static EditOp cropTo(const cv::Rect2f& crop);
+    static EditOp binarize(const BinarizationParams& params = {});
+    static EditOp colorCorrect(double gain, double bias);
+};
+
+/**
+ * Ordered edit list of one page.
+ *
+ * Appending a rotation right after another rotation merges the two, so
+ * repeated clicks keep the list short. Trailing rotations are cheap enough
+ * to apply at display time; see displayLength() and trailingRotation().
+ */
+class PageEdits {
+public:
+    const std::vector<EditOp>& ops() const { return list; }
+    bool empty() const { return list.empty(); }
+    size_t size() const { return list.size(); }
+
+    /** Append a clockwise rotation, merging with a trailing rotation. */
+    void rotate(int angle);
+    void push(const EditOp& op) { list.push_back(op); }
+    void clear() { list.clear(); }
+
+    /** Replace the first `count` steps, e.g. with steps whose snap corners were resolved. */
+    void replacePrefix(size_t count, const std::vector<EditOp>& ops);
+
+    bool contains(EditKind kind) const;
+
+    /** Steps before the trailing rotations. */
+    size_t displayLength() const;
+
+    /** Sum of the trailing rotations, in degrees (0, 90, 180, 270). */
+    int trailingRotation() const;
+
+    /** Hash of the first `count` steps; see hashEditPrefix(). */
+    uint64_t prefixHash(size_t count) const;
+
+private:
+    std::vector<EditOp> list;
+};
+
+/** Hash of an edit list prefix extended by one step. */
+uint64_t hashEditOp(uint64_t prefix, const EditOp& op);
+
+/** Hash of the first `count` steps of `ops`; equal steps give equal hashes. */
+uint64_t hashEditPrefix(const std::vector<EditOp>& ops, size_t count);
+
+/**
+ * Memoized intermediate results of one page's edit list, keyed by the
+ * prefix hash and source size, so changing the last step re-evaluates only
+ * that step. Thread-safe; entries are evicted least recently used once the
+ * cache holds more than `maxBytes`, always keeping the newest entry.
+ */
+class EditCache {
+public:
+    explicit EditCache(size_t maxBytes = kDefaultMaxBytes) : maxBytes(maxBytes) {}
+
+    static constexpr size_t kDefaultMaxBytes = 256u * 1024 * 1024;
+
+    bool find(uint64_t key, cv::Mat& image);
+    void insert(uint64_t key, const cv::Mat& image);
+    void clear();
+    size_t byteSize() const;
+
+private:
+    struct Entry {
+        uint64_t key;
+        cv::Mat image;
+    };
+
+    mutable std::mutex mutex;
+    std::list<Entry> entries;  // front = most recently used
+    size_t bytes{0};
+    size_t maxBytes;
+};
+
+/** Result of evaluateEdits(). */
+struct EditEvaluation {
+    cv::Mat image;
+    std::vector<EditOp> resolved;  // the evaluated steps, snap corners filled in, failed steps removed
+    size_t failedSteps{0};         // snaps that found no document and were skipped
+    size_t cachedSteps{0};         // leading steps reused from the cache
+};
+
+/**
+ * Evaluate the first `count` steps of `ops` on `source`.
+ *
+ * Starts from the longest prefix found in `cache` (if given) and stores each
+ * newly computed step there. Rotations directly after a snap are done by the
+ * snap's perspective warp and cached only together with it. Snap steps
+ * without corners run detection on their input; the detected corners are
+ * returned in `resolved` so callers can write them back and re-evaluation
+ * stays deterministic. Results share pixels with the cache and the source:
+ * treat them as read-only.
+ */
+EditEvaluation evaluateEdits(const cv::Mat& source, const std::vector<EditOp>& ops, size_t count,
+                             EditCache* cache = nullptr);
+
+#endif // PAGE_EDITS_H
@@ -0,0 +1,573 @@
+#include "page_list.h"
+#include "page_store.h"
+#include "cv_qt_bridge.h"
+#include "trace.h"
+#include <QAbstractItemView>
+#include <QApplication>
+#include <QCursor>
+#include <QDrag>
+#include <QDropEvent>
+#include <QFileInfo>
+#include <QHelpEvent>
+#include <QMimeData>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QScrollBar>
+#include <QStyle>
+#include <QStyleOption>
+#include <QToolTip>
+#include <QTransform>
+#include <algorithm>
+
+namespace {
+// Thumbnails of rows scrolled out of view are re-rendered when they return
+constexpr int kThumbnailCacheRows = 256;
+
+constexpr int kMargin = 4;
+constexpr int kButtonSize = 28;
+constexpr int kButtonSpacing = 4;
+constexpr int kBadgeSize = 20;
+
+// Scale a thumbnail level into a box and apply the page's pending view
+// rotation. Quarter turns are exact, so rotating after scaling stays cheap.
+QPixmap renderThumbnail(const cv::Mat &level, int viewRotation, int boxSize)
+{
+    QPixmap pixmap = QPixmap::fromImage(matToQImage(level));
+    if (pixmap.isNull())
+        return pixmap;
+    pixmap = pixmap.scaled(boxSize, boxSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    if (viewRotation != 0)
+        pixmap = pixmap.transformed(QTransform().rotate(viewRotation));
+    return pixmap;
+}
+} // namespace
+
+// Implementation of PageListModel
+PageListModel::PageListModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+    thumbnails.setMaxCost(kThumbnailCacheRows);
+}
+
+void PageListModel::setPages(const std::vector<ImageProcessingState*> &states)
+{
+    beginResetModel();
+    for (auto &entry : status)
+        delete entry.second.processor;  // cancels its job, if any
+    status.clear();
+    thumbnails.clear();
+    order = states;
+    rows.clear();
+    rows.reserve(order.size());
+    for (size_t row = 0; row < order.size(); ++row)
+        rows[order[row]] = static_cast<int>(row);
+    endResetModel();
+}
+
+void PageListModel::clear()
+{
+    setPages({});
+}
+
+ImageProcessingState *PageListModel::page(int row) const
+{
+    return row >= 0 && row < static_cast<int>(order.size()) ? order[row] : nullptr;
+}
+
+int PageListModel::rowOf(const ImageProcessingState *state) const
+{
+    auto it = rows.find(state);
+    return it == rows.end() ? -1 : it->second;
+}
+
+void PageListModel::rotatePage(ImageProcessingState *state, int angle)
+{
+    if (!state)
+        return;
+
+    // A rotation is only ever appended after the baked steps, so it is shown
+    // as a view transform and materialized at export; no job is needed.
+    state->edits.rotate(angle);
+    notifyChanged(state);
+}
+
+void PageListModel::snapPage(ImageProcessingState *state, bool userRequested)
+{
+    if (!state)
+        return;
+
+    // Snap whatever the earlier steps produce, rotation included
+    if (!state->isSnapped())
+        state->edits.push(EditOp::snap());
+    requestProcessing(state, userRequested);
+}
+
+void PageListModel::revertPage(ImageProcessingState *state)
+{
+    if (!state || state->edits.empty())
+        return;
+
+    // The original is the current image at once, for export and eviction;
+    // the job rebuilds the pyramid off the GUI thread (decoding first if
+    // the page was evicted) and supersedes any job still running
+    state->edits.clear();
+    state->currentImage = state->originalImage;
+    state->appliedSteps = 0;
+    if (pageStore)
+        pageStore->discardSpill(state);
+    status[state].error.clear();
+    requestProcessing(state, false);
+    notifyChanged(state);
+    emit pageReverted(state);
+}
+
+void PageListModel::ensureLoaded(ImageProcessingState *state)
+{
+    if (!state || !state->currentImage.empty() || isBusy(state))
+        return;
+    requestProcessing(state, false);
+}
+
+bool PageListModel::isBusy(const ImageProcessingState *state) const
+{
+    auto it = status.find(state);
+    return it != status.end() && it->second.busy;
+}
+
+void PageListModel::triggerAction(int row, PageAction action)
+{
+    ImageProcessingState *state = page(row);
+    switch (action) {
+    case PageAction::RotateLeft:
+        rotatePage(state, 270);
+        break;
+    case PageAction::RotateRight:
+        rotatePage(state, 90);
+        break;
+    case PageAction::Snap:
+        snapPage(state);
+        break;
+    case PageAction::Revert:
+        revertPage(state);
+        break;
+    }
+}
+
+PageProcessor *PageListModel::processorFor(ImageProcessingState *state)
+{
+    PageStatus &entry = status[state];
+    if (!entry.processor) {
+        entry.processor = new PageProcessor(this);
+        connect(entry.processor, &PageProcessor::busyChanged, this, [this, state](bool busy) {
+            status[state].busy = busy;
+            const int row = rowOf(state);
+            if (row >= 0)
+                emit dataChanged(index(row), index(row), {BusyRole});
+            emit pageBusyChanged(state, busy);
+        });
+        connect(entry.processor, &PageProcessor::finished, this, [this, state](const PageJobResult &result) {
+            onProcessingFinished(state, result);
+        });
+        connect(entry.processor, &PageProcessor::previewReady, this, [this, state](const PageJobResult &result) {
+            onPreviewReady(state, result);
+        });
+    }
+    return entry.processor;
+}
+
+// Queue a background job that bakes the page's edit steps, up to its
+// trailing rotations, into currentImage
+void PageListModel::requestProcessing(ImageProcessingState *state, bool snapRequested)
+{
+    PageJob job;
+    job.original = state->originalImage;
+    if (job.original.empty())
+        job.preview = state->previewImage;
+    job.sourcePath = state->filename.toStdString();
+    const std::vector<EditOp> &ops = state->edits.ops();
+    job.edits.assign(ops.begin(), ops.begin() + static_cast<std::ptrdiff_t>(state->edits.displayLength()));
+    job.cache = state->editCache;
+    job.cachedImagePath = state->spillPath.toStdString();
+    job.cachedEditsHash = state->spillHash;
+    job.snapRequested = snapRequested;
+    if (traceEnabled())
+        job.pageIndex = rowOf(state);
+    processorFor(state)->request(job);
+}
+
+void PageListModel::onProcessingFinished(ImageProcessingState *state, const PageJobResult &result)
+{
+    PageStatus &entry = status[state];
+    if (result.loadFailed) {
+        entry.error = tr("Failed to load image: %1").arg(QFileInfo(state->filename).fileName());
+        notifyChanged(state);
+        return;
+    }
+    if (state->originalImage.empty())
+        state->originalImage = result.original;
+
+    // Steps come back with detected corners filled in and failed snaps
+    // dropped; later rotations appended meanwhile are kept after them
+    state->edits.replacePrefix(result.evaluatedSteps, result.resolvedEdits);
+    if (result.failedSteps > 0 && result.snapRequested)
+        entry.error = tr("No document detected in %1").arg(QFileInfo(state->filename).fileName());
+    else
+        entry.error.clear();
+
+    if (!result.fromCache && pageStore) {
+        // The spilled copy no longer matches the page
+        pageStore->discardSpill(state);
+    }
+    state->currentImage = result.image;
+    state->appliedSteps = result.resolvedEdits.size();
+    state->displaySteps = state->appliedSteps;
+    state->pyramid = result.pyramid;
+    notifyChanged(state);
+}
+
+// Edits evaluated on the reduced decode: show them until the full result lands
+void PageListModel::onPreviewReady(ImageProcessingState *state, const PageJobResult &result)
+{
+    if (!state->currentImage.empty())
+        return;
+    state->displaySteps = result.evaluatedSteps;
+    state->pyramid = result.pyramid;
+    notifyChanged(state);
+}
+
+void PageListModel::notifyChanged(ImageProcessingState *state)
+{
+    const int row = rowOf(state);
+    if (row >= 0)
+        emit dataChanged(index(row), index(row));
+    emit pageModified(state);
+}
+
+// Thumbnail of a page as shown in its row, rendered on first paint and
+// re-rendered whenever its pyramid level or view rotation changes
+QPixmap PageListModel::thumbnail(ImageProcessingState *state) const
+{
+    const cv::Mat &level = state->pyramid.level(ImagePyramid::Level::Thumbnail);
+    const int rotation = state->viewRotation();
+    Thumbnail *cached = thumbnails.object(state);
+    if (cached && cached->level.data == level.data && cached->level.size() == level.size()
+            && cached->rotation == rotation)
+        return cached->pixmap;
+
+    auto *entry = new Thumbnail{level, rotation, renderThumbnail(level, rotation, kThumbnailSize)};
+    const QPixmap pixmap = entry->pixmap;
+    thumbnails.insert(state, entry);
+    return pixmap;
+}
+
+int PageListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(order.size());
+}
+
+QVariant PageListModel::data(const QModelIndex &index, int role) const
+{
+    ImageProcessingState *state = page(index.row());
+    if (!state)
+        return QVariant();
+
+    switch (role) {
+    case Qt::DisplayRole:
+        return QFileInfo(state->filename).fileName();
+    case Qt::DecorationRole:
+        return thumbnail(state);
+    case Qt::ToolTipRole: {
+        auto it = status.find(state);
+        if (it != status.end() && !it->second.error.isEmpty())
+            return it->second.error;
+        return QFileInfo(state->filename).fileName();
+    }
+    case BusyRole:
+        return isBusy(state);
+    case ErrorRole: {
+        auto it = status.find(state);
+        return it != status.end() ? it->second.error : QString();
+    }
+    case EditedRole:
+        return !state->edits.empty();
+    default:
+        return QVariant();
+    }
+}
+
+Qt::ItemFlags PageListModel::flags(const QModelIndex &index) const
+{
+    // Rows can be dragged; drops land between rows, never onto one
+    if (!index.isValid())
+        return Qt::ItemIsDropEnabled;
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsDragEnabled;
+}
+
+Qt::DropActions PageListModel::supportedDropActions() const
+{
+    return Qt::MoveAction;
+}
+
+const char *PageListModel::rowMimeType()
+{
+    return "application/x-pixlscan-page-row";
+}
+
+QStringList PageListModel::mimeTypes() const
+{
+    return {QString::fromLatin1(rowMimeType())};
+}
+
+QMimeData *PageListModel::mimeData(const QModelIndexList &indexes) const
+{
+    if (indexes.isEmpty())
+        return nullptr;
+    auto *mimeData = new QMimeData;
+    mimeData->setData(QString::fromLatin1(rowMimeType()), QByteArray::number(indexes.first().row()));
+    return mimeData;
+}
+
+bool PageListModel::moveRows(const QModelIndex &sourceParent, int sourceRow, int count,
+                             const QModelIndex &destinationParent, int destinationChild)
+{
+    const int pageCount = static_cast<int>(order.size());
+    if (sourceParent.isValid() || destinationParent.isValid() || count < 1 || sourceRow < 0
+            || sourceRow + count > pageCount || destinationChild < 0 || destinationChild > pageCount
+            || (destinationChild >= sourceRow && destinationChild <= sourceRow + count))
+        return false;  // out of range, or a move onto itself
+    if (!beginMoveRows(QModelIndex(), sourceRow, sourceRow + count - 1, QModelIndex(), destinationChild))
+        return false;
+    const auto first = order.begin() + sourceRow;
+    const auto last = first + count;
+    // Only the rows between source and destination change position
+    int begin, end;
+    if (destinationChild < sourceRow) {
+        std::rotate(order.begin() + destinationChild, first, last);
+        begin = destinationChild;
+        end = sourceRow + count;
+    } else {
+        std::rotate(first, last, order.begin() + destinationChild);
+        begin = sourceRow;
+        end = destinationChild;
+    }
+    for (int row = begin; row < end; ++row)
+        rows[order[row]] = row;
+    endMoveRows();
+    return true;
+}
+
+// Implementation of PageItemDelegate
+PageItemDelegate::PageItemDelegate(QObject *parent)
+    : QStyledItemDelegate(parent)
+{
+}
+
+QRect PageItemDelegate::thumbnailRect(const QRect &row)
+{
+    const int size = PageListModel::kThumbnailSize;
+    return QRect(row.x() + (row.width() - size) / 2, row.y() + kMargin, size, size);
+}
+
+QRect PageItemDelegate::buttonRect(const QRect &row, PageAction action)
+{
+    const int buttons = 4;
+    const int width = buttons * kButtonSize + (buttons - 1) * kButtonSpacing;
+    const int left = row.x() + (row.width() - width) / 2 + static_cast<int>(action) * (kButtonSize + kButtonSpacing);
+    const int top = thumbnailRect(row).bottom() + 1 + kMargin;
+    return QRect(left, top, kButtonSize, kButtonSize);
+}
+
+QSize PageItemDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &) const
+{
+    // Every row has the same height, which lets the view lay out thousands
+    // of rows without measuring them
+    return QSize(option.rect.width(), kMargin + PageListModel::kThumbnailSize + kMargin + kButtonSize + kMargin);
+}
+
+void PageItemDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    painter->save();
+    const QRect thumbRect = thumbnailRect(option.rect);
+    const QPixmap pixmap = index.data(Qt::DecorationRole).value<QPixmap>();
+    if (!pixmap.isNull()) {
+        const QSize size = pixmap.size().scaled(thumbRect.size(), Qt::KeepAspectRatio);
+        const QRect target(thumbRect.x() + (thumbRect.width() - size.width()) / 2,
+                           thumbRect.y() + (thumbRect.height() - size.height()) / 2, size.width(), size.height());
+        painter->setRenderHint(QPainter::SmoothPixmapTransform);
+        painter->drawPixmap(target, pixmap);
+    }
+
+    // Frame: highlighted for the page in the preview
+    const bool selected = option.state & QStyle::State_Selected;
+    const int frameWidth = selected ? 3 : 2;
+    painter->setPen(QPen(selected ? QColor("#3daee9") : QColor("#555"), frameWidth));
+    painter->setBrush(Qt::NoBrush);
+    painter->drawRect(thumbRect.adjusted(frameWidth / 2, frameWidth / 2, -(frameWidth + 1) / 2, -(frameWidth + 1) / 2));
+
+    if (index.data(PageListModel::BusyRole).toBool()) {
+        painter->fillRect(thumbRect, QColor(0, 0, 0, 150));
+        painter->setPen(Qt::white);
+        painter->drawText(thumbRect, Qt::AlignCenter, tr("Processing..."));
+    }
+
+    if (!index.data(PageListModel::ErrorRole).toString().isEmpty()) {
+        const QRect badge(thumbRect.right() - kBadgeSize - kMargin + 1, thumbRect.y() + kMargin, kBadgeSize, kBadgeSize);
+        painter->setRenderHint(QPainter::Antialiasing);
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(QColor("#da4453"));
+        painter->drawEllipse(badge);
+        painter->setPen(Qt::white);
+        QFont font = option.font;
+        font.setBold(true);
+        painter->setFont(font);
+        painter->drawText(badge, Qt::AlignCenter, QStringLiteral("!"));
+    }
+
+    // Buttons are drawn as auto-raise tool buttons; the one under the mouse
+    // is raised
+    const QWidget *widget = option.widget;
+    QStyle *style = widget ? widget->style() : QApplication::style();
+    const QPoint mouse = widget ? widget->mapFromGlobal(QCursor::pos()) : QPoint(-1, -1);
+    const bool edited = index.data(PageListModel::EditedRole).toBool();
+    const struct {
+        PageAction action;
+        QStyle::StandardPixmap icon;
+    } buttons[] = {
+        {PageAction::RotateLeft, QStyle::SP_ArrowBack},
+        {PageAction::RotateRight, QStyle::SP_ArrowForward},
+        {PageAction::Snap, QStyle::SP_FileDialogContentsView},
+        {PageAction::Revert, QStyle::SP_DialogResetButton},
+    };
+    for (const auto &button : buttons) {
+        QStyleOptionToolButton buttonOption;
+        if (widget)
+            buttonOption.initFrom(widget);
+        buttonOption.rect = buttonRect(option.rect, button.action);
+        buttonOption.icon = style->standardIcon(button.icon, nullptr, widget);
+        buttonOption.iconSize = QSize(20, 20);
+        buttonOption.toolButtonStyle = Qt::ToolButtonIconOnly;
+        buttonOption.subControls = QStyle::SC_ToolButton;
+        // Nothing to revert on an unedited page
+        const bool enabled = button.action != PageAction::Revert || edited;
+        buttonOption.state = QStyle::State_AutoRaise;
+        if (enabled)
+            buttonOption.state |= QStyle::State_Enabled;
+        if (enabled && buttonOption.rect.contains(mouse))
+            buttonOption.state |= QStyle::State_MouseOver | QStyle::State_Raised;
+        style->drawComplexControl(QStyle::CC_ToolButton, &buttonOption, painter, widget);
+    }
+    painter->restore();
+}
+
+bool PageItemDelegate::editorEvent(QEvent *event, QAbstractItemModel *model, const QStyleOptionViewItem &option,
+                                   const QModelIndex &index)
+{
+    if (event->type() == QEvent::MouseButtonRelease || event->type() == QEvent::MouseButtonPress
+            || event->type() == QEvent::MouseButtonDblClick) {
+        auto *mouseEvent = static_cast<QMouseEvent *>(event);
+        for (PageAction action : {PageAction::RotateLeft, PageAction::RotateRight, PageAction::Snap,
+                                  PageAction::Revert}) {
+            if (!buttonRect(option.rect, action).contains(mouseEvent->pos()))
+                continue;
+            // Act on release, and keep presses on a button from selecting
+            // the row or starting a drag
+            if (event->type() == QEvent::MouseButtonRelease && mouseEvent->button() == Qt::LeftButton)
+                emit actionTriggered(index.row(), action);
+            return true;
+        }
+    }
+    return QStyledItemDelegate::editorEvent(event, model, option, index);
+}
+
+bool PageItemDelegate::helpEvent(QHelpEvent *event, QAbstractItemView *view, const QStyleOptionViewItem &option,
+                                 const QModelIndex &index)
+{
+    if (event->type() == QEvent::ToolTip) {
+        const struct {
+            PageAction action;
+            const char *text;
+        } tips[] = {
+            {PageAction::RotateLeft, QT_TR_NOOP("Rotate Left")},
+            {PageAction::RotateRight, QT_TR_NOOP("Rotate Right")},
+            {PageAction::Snap, QT_TR_NOOP("Snap Document")},
+            {PageAction::Revert, QT_TR_NOOP("Revert to Original")},
+        };
+        for (const auto &tip : tips) {
+            const QRect rect = buttonRect(option.rect, tip.action);
+            if (rect.contains(event->pos())) {
+                QToolTip::showText(event->globalPos(), tr(tip.text), view, rect);
+                return true;
+            }
+        }
+    }
+    return QStyledItemDelegate::helpEvent(event, view, option, index);
+}
+
+// Implementation of PageListView
+PageListView::PageListView(QWidget *parent)
+    : QListView(parent)
+{
+    setUniformItemSizes(true);
+    setSelectionMode(QAbstractItemView::SingleSelection);
+    setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
+    setDragEnabled(true);
+    setAcceptDrops(true);
+    setDropIndicatorShown(true);
+    setDragDropMode(QAbstractItemView::InternalMove);
+    setDefaultDropAction(Qt::MoveAction);
+    setMouseTracking(true);  // hover state of the row buttons
+    viewport()->setAttribute(Qt::WA_Hover);
+}
+
+std::pair<int, int> PageListView::visibleRows() const
+{
+    if (!model() || model()->rowCount() == 0)
+        return {-1, -1};
+    const QRect area = viewport()->rect();
+    const QModelIndex first = indexAt(area.topLeft());
+    const QModelIndex last = indexAt(QPoint(area.left(), area.bottom()));
+    return {first.isValid() ? first.row() : 0, last.isValid() ? last.row() : model()->rowCount() - 1};
+}
+
+// The dragged row travels as its row number; the drop moves it in the model.
+// QAbstractItemView's default drag would instead remove the source row once
+// a move completes.
+void PageListView::startDrag(Qt::DropActions)
+{
+    const QModelIndex index = currentIndex();
+    if (!index.isValid())
+        return;
+    auto *drag = new QDrag(this);
+    drag->setMimeData(model()->mimeData({index}));
+    const QPixmap pixmap = index.data(Qt::DecorationRole).value<QPixmap>();
+    if (!pixmap.isNull()) {
+        drag->setPixmap(pixmap.scaled(pixmap.size() * 0.8, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+        drag->setHotSpot(QPoint(drag->pixmap().width() / 2, drag->pixmap().height() / 2));
+    }
+    drag->exec(Qt::MoveAction);
+}
+
+void PageListView::dropEvent(QDropEvent *event)
+{
+    const QString mimeType = QString::fromLatin1(PageListModel::rowMimeType());
+    if (event->source() != this || !event->mimeData()->hasFormat(mimeType)) {
+        event->ignore();
+        return;
+    }
+
+    bool ok = false;
+    const int from = event->mimeData()->data(mimeType).toInt(&ok);
+    const QModelIndex target = indexAt(event->pos());
+    int to = target.isValid() ? target.row() : model()->rowCount();
+    if (target.isValid() && dropIndicatorPosition() == QAbstractItemView::BelowItem)
+        ++to;
+    if (ok && model()->moveRow(QModelIndex(), from, QModelIndex(), to))
+        setCurrentIndex(model()->index(to > from ? to - 1 : to, 0));
+
+    event->setDropAction(Qt::MoveAction);
+    event->accept();
+    // What QAbstractItemView::dropEvent does once a drop is handled
+    stopAutoScroll();
+    setState(QAbstractItemView::NoState);
+    viewport()->update();
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QCache>
+#include <QListView>
+#include <QPixmap>
+#include <QStyledItemDelegate>
+#include <opencv2/core.hpp>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "page_processor.h"
+#include "page_state.h"
+
+class PageStore;
+
+// Buttons drawn on each thumbnail row
+enum class PageAction {
+    RotateLeft,
+    RotateRight,
+    Snap,
+    Revert
+};
+
+// The pages of the processing view, one row each, in page order.
+//
+// MainWindow owns the states; the model owns their order, a PageProcessor
+// per page (created on the page's first job) and each row's busy and error
+// status. Thumbnails are rendered on demand for the rows being painted and
+// kept in a small cache, so thousands of pages cost one pointer each until
+// scrolled into view. A row index makes looking up a page's row constant
+// time; moving rows is one beginMoveRows/endMoveRows and only re-indexes the
+// rows between the source and the destination.
+class PageListModel : public QAbstractListModel {
+    Q_OBJECT
+public:
+    enum Role {
+        BusyRole = Qt::UserRole + 1,  // bool: a background job is running
+        ErrorRole,                    // QString: why the last job failed, empty if it did not
+        EditedRole                    // bool: the page has edit steps to revert
+    };
+
+    static constexpr int kThumbnailSize = 120;
+
+    explicit PageListModel(QObject *parent = nullptr);
+
+    // Store that spilled the pages' copies; stale copies are discarded through it
+    void setPageStore(PageStore *store) { pageStore = store; }
+
+    // Replace all rows; the states must outlive the model's use of them
+    void setPages(const std::vector<ImageProcessingState*> &states);
+    void clear();
+
+    const std::vector<ImageProcessingState*> &pages() const { return order; }
+    ImageProcessingState *page(int row) const;
+    int rowOf(const ImageProcessingState *state) const;
+
+    // Edits. Rotations are view transforms and return at once; snapping and
+    // loading queue a job on the page's processor.
+    void rotatePage(ImageProcessingState *state, int angle);
+    // A snap the operator did not ask for reports no error if it finds no
+    // document
+    void snapPage(ImageProcessingState *state, bool userRequested = true);
+    // Drop all edit steps and go back to the page's original pixels
+    void revertPage(ImageProcessingState *state);
+    // Decode full-resolution pixels in the background if not done yet
+    void ensureLoaded(ImageProcessingState *state);
+    bool isBusy(const ImageProcessingState *state) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+    Qt::DropActions supportedDropActions() const override;
+    QStringList mimeTypes() const override;
+    QMimeData *mimeData(const QModelIndexList &indexes) const override;
+    bool moveRows(const QModelIndex &sourceParent, int sourceRow, int count,
+                  const QModelIndex &destinationParent, int destinationChild) override;
+
+    // MIME type of a dragged row: its row number as text
+    static const char *rowMimeType();
+
+public slots:
+    void triggerAction(int row, PageAction action);
+
+signals:
+    // Edits, pixels or status of a page changed
+    void pageModified(ImageProcessingState *state);
+    // A background job for the page started or finished
+    void pageBusyChanged(ImageProcessingState *state, bool busy);
+    void pageReverted(ImageProcessingState *state);
+
+private:
+    struct PageStatus {
+        PageProcessor *processor{nullptr};
+        bool busy{false};
+        QString error;
+    };
+
+    // Rendered thumbnail plus what it was rendered from
+    struct Thumbnail {
+        cv::Mat level;  // held so a new level never reuses its address
+        int rotation;
+        QPixmap pixmap;
+    };
+
+    PageProcessor *processorFor(ImageProcessingState *state);
+    void requestProcessing(ImageProcessingState *state, bool snapRequested);
+    void onProcessingFinished(ImageProcessingState *state, const PageJobResult &result);
+    void onPreviewReady(ImageProcessingState *state, const PageJobResult &result);
+    void notifyChanged(ImageProcessingState *state);
+    QPixmap thumbnail(ImageProcessingState *state) const;
+
+    PageStore *pageStore{nullptr};
+    std::vector<ImageProcessingState*> order;
+    std::unordered_map<const ImageProcessingState*, int> rows;  // inverse of order
+    std::unordered_map<const ImageProcessingState*, PageStatus> status;
+    mutable QCache<const ImageProcessingState*, Thumbnail> thumbnails;
+};
+
+// Paints a page row: thumbnail, selection frame, busy overlay, error badge
+// and the rotate/snap/revert buttons, which are handled here rather than being
+// real widgets.
+class PageItemDelegate : public QStyledItemDelegate {
+    Q_OBJECT
+public:
+    explicit PageItemDelegate(QObject *parent = nullptr);
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+    QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+    bool editorEvent(QEvent *event, QAbstractItemModel *model, const QStyleOptionViewItem &option,
+                     const QModelIndex &index) override;
+    bool helpEvent(QHelpEvent *event, QAbstractItemView *view, const QStyleOptionViewItem &option,
+                   const QModelIndex &index) override;
+
+signals:
+    void actionTriggered(int row, PageAction action);
+
+private:
+    static QRect thumbnailRect(const QRect &row);
+    static QRect buttonRect(const QRect &row, PageAction action);
+};
+
+// Thumbnail strip. Rows are reordered by dragging, which moves the row in
+// the model instead of copying and removing it.
+class PageListView : public QListView {
+    Q_OBJECT
+public:
+    explicit PageListView(QWidget *parent = nullptr);
+
+    // First and last row intersecting the viewport; (-1, -1) when empty
+    std::pair<int, int> visibleRows() const;
+
+protected:
+    void startDrag(Qt::DropActions supportedActions) override;
+    void dropEvent(QDropEvent *event) override;
+};
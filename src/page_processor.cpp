@@ -0,0 +1,175 @@
+#include "page_processor.h"
+#include "trace.h"
+#include <opencv2/imgcodecs.hpp>
+#include <QtConcurrent/QtConcurrentRun>
+
+namespace {
+// Clicks closer together than this are merged into one job
+constexpr int kCoalesceMs = 150;
+}
+
+PageProcessor::PageProcessor(QObject *parent)
+    : QObject(parent),
+      watcher(new QFutureWatcher<PageJobResult>(this)),
+      previewWatcher(new QFutureWatcher<PageJobResult>(this)),
+      coalesceTimer(new QTimer(this))
+{
+    coalesceTimer->setSingleShot(true);
+    coalesceTimer->setInterval(kCoalesceMs);
+    connect(coalesceTimer, &QTimer::timeout, this, &PageProcessor::startPending);
+    connect(watcher, &QFutureWatcher<PageJobResult>::finished, this, &PageProcessor::onJobFinished);
+    connect(previewWatcher, &QFutureWatcher<PageJobResult>::finished, this, &PageProcessor::onPreviewFinished);
+}
+
+PageProcessor::~PageProcessor()
+{
+    // A running job owns copies of its inputs; just tell it to stop early.
+    if (cancelFlag)
+        cancelFlag->store(true);
+}
+
+void PageProcessor::request(const PageJob &job)
+{
+    const bool snapRequested = job.snapRequested || (pending && pending->snapRequested);
+    pending = job;
+    pending->snapRequested = snapRequested;
+
+    // The running job is now stale; let it bail out at its next checkpoint
+    if (running && cancelFlag)
+        cancelFlag->store(true);
+
+    setBusy(true);
+    coalesceTimer->start();
+}
+
+void PageProcessor::startPending()
+{
+    if (running || !pending)
+        return;  // onJobFinished() starts the next job
+
+    const PageJob job = *pending;
+    pending.reset();
+    cancelFlag = std::make_shared<std::atomic<bool>>(false);
+    running = true;
+
+    auto cancelled = cancelFlag;
+    watcher->setFuture(QtConcurrent::run([job, cancelled]() {
+        return process(job, *cancelled);
+    }));
+    // Decoding the original is the slow part; show the edits on the reduced
+    // decode until the full result arrives
+    previewPending = job.original.empty() && !job.preview.empty() && !job.edits.empty();
+    if (previewPending) {
+        previewWatcher->setFuture(QtConcurrent::run([job, cancelled]() {
+            return processPreview(job, *cancelled);
+        }));
+    }
+}
+
+void PageProcessor::onJobFinished()
+{
+    running = false;
+    previewPending = false;
+    const PageJobResult result = watcher->result();
+
+    if (pending) {
+        // Superseded while running: drop the result and start the newest
+        // job, unless the coalesce window is still open for more clicks.
+        if (!coalesceTimer->isActive())
+            startPending();
+        return;
+    }
+
+    setBusy(false);
+    if (!result.cancelled)
+        emit finished(result);
+}
+
+void PageProcessor::onPreviewFinished()
+{
+    const PageJobResult result = previewWatcher->result();
+    // Only useful while its full job is still the one running
+    if (previewPending && running && !pending && !result.cancelled)
+        emit previewReady(result);
+    previewPending = false;
+}
+
+PageJobResult PageProcessor::processPreview(const PageJob &job, const std::atomic<bool> &cancelled)
+{
+    TraceSpan span("processPreview", job.pageIndex);
+    PageJobResult result;
+    result.preview = true;
+    result.snapRequested = job.snapRequested;
+    result.evaluatedSteps = job.edits.size();
+    EditEvaluation evaluation = evaluateEdits(job.preview.pixels(), job.edits, job.edits.size(), job.cache.get());
+    result.image = PageBuffer(evaluation.image);
+    result.resolvedEdits = std::move(evaluation.resolved);
+    result.failedSteps = evaluation.failedSteps;
+    if (!cancelled.load()) {
+        result.pyramid.reset(result.image.pixels());
+        result.pyramid.build();
+    }
+    result.cancelled = cancelled.load();
+    return result;
+}
+
+PageJobResult PageProcessor::process(const PageJob &job, const std::atomic<bool> &cancelled)
+{
+    TraceSpan span("processPage", job.pageIndex);
+    PageJobResult result;
+    result.snapRequested = job.snapRequested;
+    result.evaluatedSteps = job.edits.size();
+
+    // An evicted result still matching the requested edits reloads from the
+    // page store's disk cache; the original is then decoded only if a later
+    // edit needs it.
+    if (job.original.empty() && !job.cachedImagePath.empty()
+            && job.cachedEditsHash == hashEditPrefix(job.edits, job.edits.size())) {
+        result.image = PageBuffer::decode(job.cachedImagePath, cv::IMREAD_UNCHANGED);
+        if (!result.image.empty()) {
+            result.fromCache = true;
+            result.resolvedEdits = job.edits;
+            if (!cancelled.load()) {
+                result.pyramid.reset(result.image.pixels());
+                result.pyramid.build();
+            }
+            result.cancelled = cancelled.load();
+            return result;
+        }
+    }
+
+    // Full-resolution pixels are only decoded once a page is actually processed
+    result.original = job.original;
+    if (result.original.empty())
+        result.original = PageBuffer::decode(job.sourcePath, cv::IMREAD_COLOR);
+    if (result.original.empty()) {
+        result.loadFailed = true;
+        return result;
+    }
+    if (cancelled.load()) {
+        result.cancelled = true;
+        return result;
+    }
+
+    // Steps already evaluated for this page come from its edit cache, so
+    // changing the last step only recomputes that step
+    EditEvaluation evaluation = evaluateEdits(result.original.pixels(), job.edits, job.edits.size(), job.cache.get());
+    result.image = PageBuffer(evaluation.image);
+    result.resolvedEdits = std::move(evaluation.resolved);
+    result.failedSteps = evaluation.failedSteps;
+
+    if (!cancelled.load()) {
+        result.pyramid.reset(result.image.pixels());
+        result.pyramid.build();
+    }
+    result.cancelled = cancelled.load();
+    return result;
+}
+
+void PageProcessor::setBusy(bool value)
+{
+    if (busy == value)
+        return;
+    busy = value;
+    emit busyChanged(busy);
+}
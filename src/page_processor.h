@@ -0,0 +1,87 @@
+#pragma once
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QTimer>
+#include <opencv2/core.hpp>
+#include "image_pyramid.h"
+#include "page_buffer.h"
+#include "page_edits.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Everything needed to recompute a page's current pixels from its original:
+// the page's edit steps up to its trailing rotations, which stay a view
+// transform until export.
+struct PageJob {
+    PageBuffer original;    // shared with the page state; empty = decode sourcePath
+    PageBuffer preview;     // reduced decode, evaluated first while the original loads
+    std::string sourcePath;
+    std::vector<EditOp> edits;         // steps to bake into the result
+    std::shared_ptr<EditCache> cache;  // the page's memoized intermediate results
+    std::string cachedImagePath;  // spilled copy of a previous result, if any
+    uint64_t cachedEditsHash{0};  // hashEditPrefix() of the steps baked into the cached image
+    bool snapRequested{false};  // true if the user explicitly asked to snap
+    int pageIndex{-1};          // position in the page list, for tracing only
+};
+
+struct PageJobResult {
+    PageBuffer image;       // shares original's pixels unless an edit produced new ones
+    PageBuffer original;    // full-resolution pixels, decoded here if the job had to load them
+    ImagePyramid pyramid;   // display levels of image, pre-built off the GUI thread
+    std::vector<EditOp> resolvedEdits;  // the job's steps with snap corners filled in, failed ones removed
+    size_t evaluatedSteps{0};           // number of job steps resolvedEdits replaces
+    size_t failedSteps{0};              // snaps that found no document
+    bool preview{false};    // evaluated on job.preview; a full result follows
+    bool fromCache{false};  // image was reloaded from job.cachedImagePath
+    bool loadFailed{false};
+    bool snapRequested{false};
+    bool cancelled{false};
+};
+
+// Runs load/snap jobs for one page on the global thread pool.
+//
+// Requests are coalesced: repeated clicks within a short window collapse into
+// a single job built from the latest parameters, and a request arriving while
+// a job is in flight cancels that job and queues the newest one behind it.
+// Only the result of the most recent request is ever delivered. A job that
+// must first decode the original also evaluates its edits on the reduced
+// preview decode and delivers that through previewReady() in the meantime.
+class PageProcessor : public QObject {
+    Q_OBJECT
+public:
+    explicit PageProcessor(QObject *parent = nullptr);
+    ~PageProcessor() override;
+
+    // Queue a job, superseding any pending or running one
+    void request(const PageJob &job);
+    bool isBusy() const { return busy; }
+
+signals:
+    void busyChanged(bool busy);
+    void finished(const PageJobResult &result);
+    void previewReady(const PageJobResult &result);
+
+private slots:
+    void startPending();
+    void onJobFinished();
+    void onPreviewFinished();
+
+private:
+    static PageJobResult process(const PageJob &job, const std::atomic<bool> &cancelled);
+    static PageJobResult processPreview(const PageJob &job, const std::atomic<bool> &cancelled);
+    void setBusy(bool value);
+
+    QFutureWatcher<PageJobResult> *watcher;
+    QFutureWatcher<PageJobResult> *previewWatcher;
+    QTimer *coalesceTimer;
+    std::optional<PageJob> pending;
+    std::shared_ptr<std::atomic<bool>> cancelFlag;
+    bool running{false};
+    bool previewPending{false};  // previewWatcher belongs to the running job
+    bool busy{false};
+};
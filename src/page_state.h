@@ -0,0 +1,43 @@
+#pragma once
+
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "image_pyramid.h"
+#include "page_buffer.h"
+#include "page_edits.h"
+
+// Structure to track image processing state
+struct ImageProcessingState {
+    // Copies of the state share pixels; only a snap warp allocates new ones
+    PageBuffer previewImage;   // Reduced-resolution decode from staging, used until full pixels exist
+    PageBuffer originalImage;  // Full resolution, decoded lazily when the page is first processed
+    PageBuffer currentImage;   // Empty until the page has been loaded or processed; see viewRotation()
+    ImagePyramid pyramid;   // Display levels of currentImage (or previewImage until loaded)
+    QString filename;
+    PageEdits edits;        // Non-destructive edit steps, applied to originalImage in order
+    size_t appliedSteps{0}; // Leading steps of edits baked into currentImage
+    size_t displaySteps{0}; // Leading steps of edits baked into pyramid; ahead of appliedSteps while a preview shows
+    std::shared_ptr<EditCache> editCache;  // Memoized intermediate results; shared by copies of the state
+    QString spillPath;      // Disk copy of an edited currentImage, written when the page store evicts it
+    uint64_t spillHash{0};  // edits.prefixHash() of the steps baked into spillPath
+    bool autoSnapTried{false};  // Auto-snap ran on the page or the operator reverted it; never queued again
+
+    bool isSnapped() const { return edits.contains(EditKind::Snap); }
+
+    // Rotation still to apply on top of the pyramid when displaying
+    int viewRotation() const { return pendingRotation(displaySteps); }
+
+    // Rotation among the steps after the first `baked`; other pending steps
+    // are on their way from a background job
+    int pendingRotation(size_t baked) const
+    {
+        int angle = 0;
+        for (size_t i = baked; i < edits.size(); ++i) {
+            if (edits.ops()[i].kind == EditKind::Rotate)
+                angle += edits.ops()[i].angle;
+        }
+        return angle % 360;
+    }
+};
@@ -0,0 +1,176 @@
+#include "page_store.h"
+#include "page_state.h"
+#include "Logger.hpp"
+#include <QFile>
+#include <QSaveFile>
+#include <QtConcurrent/QtConcurrentRun>
+#include <opencv2/imgcodecs.hpp>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+constexpr size_t kDefaultBudgetMiB = 2048;
+// Fast zlib level: spilling must not stall eviction for long
+constexpr int kSpillPngCompression = 1;
+
+size_t budgetFromEnvironment()
+{
+    const char *env = std::getenv("PIXLSCAN_MEMORY_BUDGET_MB");
+    const long long mib = env ? std::atoll(env) : 0;
+    return static_cast<size_t>(mib > 0 ? mib : static_cast<long long>(kDefaultBudgetMiB)) * 1024 * 1024;
+}
+} // namespace
+
+PageStore::PageStore()
+    : budgetBytes(budgetFromEnvironment())
+{
+}
+
+PageStore::~PageStore()
+{
+    cancelSpills();
+}
+
+void PageStore::clear()
+{
+    cancelSpills();  // before their directory goes away
+    lru.clear();
+    index.clear();
+    resident = 0;
+    spillDir.reset();  // removes every spilled page
+    spillCounter = 0;
+}
+
+void PageStore::touch(ImageProcessingState *state)
+{
+    if (!state)
+        return;
+    auto it = index.find(state);
+    if (it != index.end()) {
+        resident -= it->second->bytes;
+        lru.erase(it->second);
+        index.erase(it);
+    }
+    const size_t bytes = pixelBytes(*state);
+    if (bytes == 0)
+        return;  // nothing resident to track yet
+    lru.push_front({state, bytes});
+    index[state] = lru.begin();
+    resident += bytes;
+}
+
+void PageStore::enforceBudget()
+{
+    while (resident > budgetBytes && lru.size() > 1) {
+        const Entry coldest = lru.back();
+        lru.pop_back();
+        index.erase(coldest.state);
+        resident -= coldest.bytes;
+        evict(coldest.state);
+    }
+}
+
+// Unique pixel bytes held by a page; shared buffers are counted once
+size_t PageStore::pixelBytes(const ImageProcessingState &state)
+{
+    size_t bytes = state.originalImage.byteSize();
+    if (!state.currentImage.sharesPixelsWith(state.originalImage))
+        bytes += state.currentImage.byteSize();
+    // Cached edit steps may share pixels with currentImage; counting them
+    // again errs on the side of evicting early
+    if (state.editCache)
+        bytes += state.editCache->byteSize();
+    return bytes + state.pyramid.derivedBytes();
+}
+
+void PageStore::evict(ImageProcessingState *state)
+{
+    // Edited pages are not reproducible from the source alone without
+    // re-running their steps, so keep a compressed copy of them on disk
+    if (state->appliedSteps > 0 && !state->currentImage.empty() && state->spillPath.isEmpty()) {
+        state->spillPath = spill(*state);
+        state->spillHash = state->edits.prefixHash(state->appliedSteps);
+    }
+
+    Logger::debug("PageStore: evicting ", state->filename.toStdString(),
+                  state->spillPath.isEmpty() ? " (re-decode from source)" : " (spilled)");
+    state->originalImage.release();
+    state->currentImage.release();
+    if (state->editCache)
+        state->editCache->clear();
+    state->pyramid.releaseLargeLevels();
+}
+
+// Write the page's current pixels to the spill directory in the background.
+// The path is returned immediately; until the file is committed, readers
+// fall back to re-decoding the source. Removing the file goes through
+// discardSpill(), which cancels the write if it has not committed yet.
+QString PageStore::spill(const ImageProcessingState &state)
+{
+    if (!spillDir) {
+        spillDir = std::make_unique<QTemporaryDir>();
+        if (!spillDir->isValid()) {
+            Logger::warn("PageStore: cannot create spill directory; evicted pages will re-decode");
+            spillDir.reset();
+            return QString();
+        }
+    }
+
+    for (auto it = pendingSpills.begin(); it != pendingSpills.end();) {
+        if (it->future.isFinished())
+            it = pendingSpills.erase(it);
+        else
+            ++it;
+    }
+
+    const QString path = spillDir->filePath(QStringLiteral("page-%1.png").arg(spillCounter++));
+    const PageBuffer pixels = state.currentImage;  // keeps the pixels alive until written
+    auto write = std::make_shared<SpillWrite>();
+    const QFuture<void> future = QtConcurrent::run([pixels, path, write]() {
+        std::vector<uchar> encoded;
+        try {
+            if (!cv::imencode(".png", pixels.pixels(), encoded, {cv::IMWRITE_PNG_COMPRESSION, kSpillPngCompression}))
+                return;
+        } catch (const cv::Exception &) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(write->mutex);
+        if (write->cancelled)
+            return;
+        QSaveFile file(path);
+        if (file.open(QIODevice::WriteOnly)
+                && file.write(reinterpret_cast<const char *>(encoded.data()),
+                              static_cast<qint64>(encoded.size())) == static_cast<qint64>(encoded.size()))
+            file.commit();
+    });
+    pendingSpills.insert(path, {future, write});
+    return path;
+}
+
+void PageStore::discardSpill(ImageProcessingState *state)
+{
+    if (!state || state->spillPath.isEmpty())
+        return;
+    auto it = pendingSpills.find(state->spillPath);
+    if (it != pendingSpills.end()) {
+        {
+            std::lock_guard<std::mutex> lock(it->write->mutex);
+            it->write->cancelled = true;
+        }
+        pendingSpills.erase(it);
+    }
+    QFile::remove(state->spillPath);
+    state->spillPath.clear();
+}
+
+void PageStore::cancelSpills()
+{
+    for (PendingSpill &pending : pendingSpills) {
+        {
+            std::lock_guard<std::mutex> lock(pending.write->mutex);
+            pending.write->cancelled = true;
+        }
+        pending.future.waitForFinished();
+    }
+    pendingSpills.clear();
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QFuture>
+#include <QHash>
+#include <QString>
+#include <QTemporaryDir>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+struct ImageProcessingState;
+
+// Keeps the full-resolution pixels of all pages within a memory budget.
+//
+// Pages are ordered by last use (display, edit, visible in the thumbnail
+// list). When the resident total exceeds the budget the least recently used
+// pages are evicted: their originals and current images are released and
+// only the thumbnail level stays, and the page's edit cache is cleared.
+// Untouched pages simply re-decode from their source file; edited pages are
+// first spilled to a compressed disk cache so reloading skips their steps.
+// Reloading goes through the usual paths (PageListModel::ensureLoaded,
+// MainWindow::exportImage).
+//
+// GUI thread only. The budget defaults to PIXLSCAN_MEMORY_BUDGET_MB or 2 GiB.
+class PageStore {
+public:
+    PageStore();
+    ~PageStore();
+
+    void setBudget(size_t bytes) { budgetBytes = bytes; }
+    size_t budget() const { return budgetBytes; }
+    size_t residentBytes() const { return resident; }
+
+    // Forget all pages; call before the states are destroyed. Waits for
+    // spill writes still running.
+    void clear();
+
+    // Mark a page as just used and re-measure its resident pixels
+    void touch(ImageProcessingState *state);
+
+    // Evict least recently used pages until within budget. The most recently
+    // used page is never evicted, however large it is.
+    void enforceBudget();
+
+    // Delete the page's spilled copy once it no longer matches the page.
+    // A write still in flight is cancelled, or finishes before the removal.
+    void discardSpill(ImageProcessingState *state);
+
+private:
+    struct Entry {
+        ImageProcessingState *state;
+        size_t bytes;
+    };
+
+    // Spill write running on the thread pool. The worker commits the file
+    // under the mutex only if not cancelled, so whoever sets `cancelled`
+    // under it knows no file appears afterwards.
+    struct SpillWrite {
+        std::mutex mutex;
+        bool cancelled{false};
+    };
+    struct PendingSpill {
+        QFuture<void> future;
+        std::shared_ptr<SpillWrite> write;
+    };
+
+    static size_t pixelBytes(const ImageProcessingState &state);
+    void evict(ImageProcessingState *state);
+    QString spill(const ImageProcessingState &state);
+    void cancelSpills();
+
+    std::list<Entry> lru;  // front = most recently used; resident pages only
+    std::unordered_map<ImageProcessingState*, std::list<Entry>::iterator> index;
+    size_t budgetBytes;
+    size_t resident{0};
+    std::unique_ptr<QTemporaryDir> spillDir;  // created on first spill
+    int spillCounter{0};
+    QHash<QString, PendingSpill> pendingSpills;  // by path; finished ones are pruned on the next spill
+};
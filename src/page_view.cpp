@@ -0,0 +1,369 @@
+#include "page_view.h"
+#include "cv_qt_bridge.h"
+#include "trace.h"
+#include <QFutureWatcher>
+#include <QGraphicsItem>
+#include <QGraphicsScene>
+#include <QGraphicsSimpleTextItem>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QThreadPool>
+#include <QWheelEvent>
+#include <QtConcurrent/QtConcurrentRun>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Tiles are about 768 KiB each for color pages; this holds a few screens
+// of them at any zoom
+constexpr int kTileCacheKiB = 192 * 1024;
+// Tiles asked for by paints that have since scrolled away are dropped
+constexpr int kMaxQueuedTiles = 256;
+constexpr double kWheelZoomStep = 1.25;
+constexpr double kMaxZoom = 8.0;  // screen pixels per image pixel
+
+// Cut one tile out of the full image and shrink it to its level; runs on a
+// pool thread
+QImage renderTile(const cv::Mat &full, int level, const QRectF &rect)
+{
+    TraceSpan span("renderTile");
+    const cv::Rect region = cv::Rect(static_cast<int>(rect.x()), static_cast<int>(rect.y()),
+                                     static_cast<int>(rect.width()), static_cast<int>(rect.height()))
+                          & cv::Rect(0, 0, full.cols, full.rows);
+    if (region.empty())
+        return QImage();
+    cv::Mat pixels = full(region);  // shares pixels; the QImage keeps them alive
+    if (level > 0) {
+        const int shrink = 1 << level;
+        cv::Mat scaled;
+        cv::resize(pixels, scaled, cv::Size((region.width + shrink - 1) / shrink, (region.height + shrink - 1) / shrink),
+                   0, 0, cv::INTER_AREA);
+        pixels = scaled;
+    }
+    return matToQImage(pixels);
+}
+} // namespace
+
+// The page in image coordinates: the overview stretched over the whole
+// page, with whatever tiles of the current level are cached drawn on top
+class TiledPageItem : public QGraphicsItem
+{
+public:
+    explicit TiledPageItem(PageView *view)
+        : view(view)
+    {
+        // Needed for option->exposedRect, so only visible tiles are requested
+        setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+    }
+
+    void setPageSize(const QSizeF &pageSize)
+    {
+        if (pageSize == size)
+            return;
+        prepareGeometryChange();
+        size = pageSize;
+        setTransformOriginPoint(size.width() / 2, size.height() / 2);
+    }
+
+    void setOverview(const QPixmap &overviewPixmap)
+    {
+        overview = overviewPixmap;
+        update();
+    }
+
+    QRectF boundingRect() const override { return QRectF(QPointF(0, 0), size); }
+
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *) override
+    {
+        const QRectF exposed = option->exposedRect & boundingRect();
+        if (exposed.isEmpty())
+            return;
+        painter->setRenderHint(QPainter::SmoothPixmapTransform);
+        if (!overview.isNull()) {
+            const double sx = overview.width() / size.width();
+            const double sy = overview.height() / size.height();
+            painter->drawPixmap(exposed, overview,
+                                QRectF(exposed.x() * sx, exposed.y() * sy, exposed.width() * sx, exposed.height() * sy));
+        }
+
+        const int level = view->currentLevel();
+        if (level < 0)
+            return;  // the overview is already as sharp as the screen
+        const double extent = PageView::kTileSize << level;
+        const int firstColumn = static_cast<int>(exposed.left() / extent);
+        const int lastColumn = static_cast<int>(std::ceil(exposed.right() / extent)) - 1;
+        const int firstRow = static_cast<int>(exposed.top() / extent);
+        const int lastRow = static_cast<int>(std::ceil(exposed.bottom() / extent)) - 1;
+        for (int row = firstRow; row <= lastRow; ++row) {
+            for (int column = firstColumn; column <= lastColumn; ++column) {
+                if (const QPixmap *pixmap = view->tile(level, column, row)) {
+                    const QRectF target = QRectF(column * extent, row * extent, extent, extent) & boundingRect();
+                    painter->drawPixmap(target, *pixmap, QRectF(pixmap->rect()));
+                }
+            }
+        }
+    }
+
+private:
+    PageView *view;
+    QPixmap overview;
+    QSizeF size;
+};
+
+PageView::PageView(QWidget *parent)
+    : QGraphicsView(parent), pageScene(new QGraphicsScene(this))
+{
+    setScene(pageScene);
+    setDragMode(QGraphicsView::ScrollHandDrag);
+    setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
+    setResizeAnchor(QGraphicsView::AnchorViewCenter);
+    setViewportUpdateMode(QGraphicsView::SmartViewportUpdate);
+    setRenderHint(QPainter::SmoothPixmapTransform);
+    setFrameShape(QFrame::NoFrame);
+    tiles.setMaxCost(kTileCacheKiB);
+}
+
+void PageView::setPage(const void *newPage, const cv::Mat &newFull, const cv::Mat &newOverview, int viewRotation)
+{
+    TraceSpan span("PageView::setPage");
+    if (message) {
+        delete message;
+        message = nullptr;
+    }
+
+    // Remember what is on screen, relative to the page, so reloading the
+    // same page (sharper pixels, another rotation) does not jump
+    const bool samePage = item && newPage == page;
+    QPointF center(0.5, 0.5);
+    double screenWidth = 0.0;
+    if (samePage && !fitMode) {
+        const QRectF bounds = item->boundingRect();
+        const QPointF at = item->mapFromScene(mapToScene(viewport()->rect().center()));
+        center = QPointF(at.x() / bounds.width(), at.y() / bounds.height());
+        screenWidth = transform().m11() * bounds.width();
+    }
+
+    if (!item) {
+        item = new TiledPageItem(this);
+        pageScene->addItem(item);
+    }
+    if (newFull.data != full.data || newFull.size() != full.size())
+        clearTiles();
+    page = newPage;
+    full = newFull;
+    const bool overviewChanged = newOverview.data != overview.data || newOverview.size() != overview.size();
+    overview = newOverview;
+    const QSizeF size = full.empty() ? QSizeF(overview.cols, overview.rows) : QSizeF(full.cols, full.rows);
+    if (!samePage || overviewChanged)
+        item->setOverview(QPixmap::fromImage(matToQImage(overview)));
+    item->setPageSize(size);
+    item->update();
+    item->setRotation(viewRotation);
+    pageScene->setSceneRect(item->sceneBoundingRect());
+
+    if (!samePage || fitMode || screenWidth <= 0.0) {
+        fitToWindow();
+        return;
+    }
+    const double zoom = screenWidth / size.width();
+    setTransform(QTransform::fromScale(zoom, zoom));
+    centerOn(item->mapToScene(QPointF(center.x() * size.width(), center.y() * size.height())));
+}
+
+void PageView::showMessage(const QString &text)
+{
+    delete item;
+    item = nullptr;
+    page = nullptr;
+    full.release();
+    overview.release();
+    clearTiles();
+    if (!message) {
+        message = pageScene->addSimpleText(text);
+        message->setBrush(palette().text());
+    }
+    message->setText(text);
+    resetTransform();
+    pageScene->setSceneRect(message->sceneBoundingRect());
+}
+
+void PageView::fitToWindow()
+{
+    fitMode = true;
+    if (!item)
+        return;
+    // Pages smaller than the viewport are shown at 1:1 rather than enlarged
+    const double zoom = std::min(fitZoom(), 1.0);
+    setTransform(QTransform::fromScale(zoom, zoom));
+    centerOn(item);
+}
+
+void PageView::zoomToActualSize()
+{
+    if (!item)
+        return;
+    fitMode = false;
+    const double zoom = 1.0 / devicePixelRatioF();  // one image pixel per device pixel
+    setTransform(QTransform::fromScale(zoom, zoom));
+}
+
+void PageView::wheelEvent(QWheelEvent *event)
+{
+    const double steps = event->angleDelta().y() / 120.0;
+    if (!item || steps == 0.0) {
+        QGraphicsView::wheelEvent(event);
+        return;
+    }
+    zoomBy(std::pow(kWheelZoomStep, steps));
+    event->accept();
+}
+
+void PageView::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    if (!item || event->button() != Qt::LeftButton) {
+        QGraphicsView::mouseDoubleClickEvent(event);
+        return;
+    }
+    if (fitMode) {
+        const QPointF anchor = mapToScene(event->pos());
+        zoomToActualSize();
+        centerOn(anchor);
+    } else {
+        fitToWindow();
+    }
+}
+
+void PageView::resizeEvent(QResizeEvent *event)
+{
+    QGraphicsView::resizeEvent(event);
+    if (fitMode)
+        fitToWindow();
+}
+
+void PageView::zoomBy(double factor)
+{
+    const double current = transform().m11();
+    const double smallest = std::min(fitZoom(), 1.0);
+    const double target = std::clamp(current * factor, smallest, kMaxZoom);
+    if (target <= smallest) {
+        fitToWindow();
+        return;
+    }
+    fitMode = false;
+    scale(target / current, target / current);
+}
+
+// Zoom at which the rotated page just fits the viewport
+double PageView::fitZoom() const
+{
+    if (!item)
+        return 1.0;
+    const QRectF bounds = item->sceneBoundingRect();
+    if (bounds.isEmpty())
+        return 1.0;
+    return std::min(viewport()->width() / bounds.width(), viewport()->height() / bounds.height());
+}
+
+// Tile level for the current zoom, or -1 while the overview suffices. Level
+// n tiles hold every 2^n-th image pixel; the coarsest level that is still at
+// least as dense as the screen is used.
+int PageView::currentLevel() const
+{
+    if (!item || full.empty() || overview.empty())
+        return -1;
+    const double density = transform().m11() * devicePixelRatioF();  // device pixels per image pixel
+    if (density * full.cols <= overview.cols)
+        return -1;
+    return std::max(0, static_cast<int>(std::floor(std::log2(1.0 / density))));
+}
+
+quint64 PageView::tileKey(int level, int column, int row)
+{
+    return (static_cast<quint64>(level) << 48) | (static_cast<quint64>(row) << 24) | static_cast<quint64>(column);
+}
+
+QRectF PageView::tileRect(quint64 key)
+{
+    const int level = static_cast<int>(key >> 48);
+    const double extent = kTileSize << level;
+    const double row = static_cast<double>((key >> 24) & 0xFFFFFF);
+    const double column = static_cast<double>(key & 0xFFFFFF);
+    return QRectF(column * extent, row * extent, extent, extent);
+}
+
+const QPixmap *PageView::tile(int level, int column, int row)
+{
+    const quint64 key = tileKey(level, column, row);
+    if (const QPixmap *pixmap = tiles.object(key))
+        return pixmap;
+    if (!inFlight.contains(key) && !queued.contains(key)) {
+        queued.append(key);
+        if (queued.size() > kMaxQueuedTiles)
+            queued.removeFirst();
+        startQueuedTiles();
+    }
+    return nullptr;
+}
+
+// True if the tile is still of the current level and intersects the viewport
+bool PageView::tileVisible(quint64 key) const
+{
+    if (!item || static_cast<int>(key >> 48) != currentLevel())
+        return false;
+    const QRectF visible = item->mapFromScene(mapToScene(viewport()->rect())).boundingRect();
+    return tileRect(key).intersects(visible);
+}
+
+// Start queued tiles, most recently requested first, keeping at most one
+// per pool thread in flight so zooming through levels never piles up work.
+// Jobs of a previous page still count until they finish.
+void PageView::startQueuedTiles()
+{
+    const int maxInFlight = std::max(1, QThreadPool::globalInstance()->maxThreadCount());
+    while (running < maxInFlight && !queued.isEmpty()) {
+        const quint64 key = queued.takeLast();
+        if (!tileVisible(key))
+            continue;  // scrolled or zoomed away since it was asked for
+        inFlight.insert(key);
+        ++running;
+
+        const cv::Mat pixels = full;
+        const int level = static_cast<int>(key >> 48);
+        const QRectF rect = tileRect(key);
+        const uint64_t tileGeneration = generation;
+        auto *watcher = new QFutureWatcher<QImage>(this);
+        connect(watcher, &QFutureWatcher<QImage>::finished, this, [this, watcher, key, tileGeneration]() {
+            watcher->deleteLater();
+            --running;
+            if (tileGeneration != generation) {
+                startQueuedTiles();  // the page changed; its tiles are gone
+                return;
+            }
+            inFlight.remove(key);
+            const QImage image = watcher->result();
+            if (!image.isNull()) {
+                auto *pixmap = new QPixmap(QPixmap::fromImage(image));
+                const int cost = std::max(1, pixmap->width() * pixmap->height() * pixmap->depth() / 8 / 1024);
+                tiles.insert(key, pixmap, cost);
+                if (item)
+                    item->update(tileRect(key) & item->boundingRect());
+            }
+            startQueuedTiles();
+        });
+        watcher->setFuture(QtConcurrent::run([pixels, level, rect]() {
+            return renderTile(pixels, level, rect);
+        }));
+    }
+}
+
+// Running jobs are not cancelled; they keep their slot until they finish
+// and their results are then dropped by generation
+void PageView::clearTiles()
+{
+    ++generation;
+    tiles.clear();
+    queued.clear();
+    inFlight.clear();
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <QCache>
+#include <QGraphicsView>
+#include <QPixmap>
+#include <QSet>
+#include <QVector>
+#include <opencv2/core.hpp>
+#include <cstdint>
+
+class QGraphicsScene;
+class QGraphicsSimpleTextItem;
+class TiledPageItem;
+
+// Zoomable, pannable preview of one page.
+//
+// The page is drawn from two sources. An overview (a pyramid level of at
+// most ImagePyramid::kPreviewSize) covers fit-to-window and acts as the
+// backdrop while zoomed in. Past the overview's resolution, the full image
+// is split into kTileSize tiles at power-of-two levels of detail; only tiles
+// that are visible at the current zoom are cut and downscaled, on the global
+// thread pool, and kept in an LRU cache. Missing tiles show the overview
+// until they arrive, so panning and zooming never wait for pixels.
+//
+// Scene coordinates are pixels of the full image (of the overview while the
+// page has not been loaded yet); the page's view rotation is applied to the
+// item. Wheel zooms around the cursor, dragging pans, and a double click
+// toggles between fit-to-window and 1:1.
+class PageView : public QGraphicsView {
+    Q_OBJECT
+public:
+    static constexpr int kTileSize = 512;
+
+    explicit PageView(QWidget *parent = nullptr);
+
+    // Show a page. Calling again for the same `page` (e.g. once full pixels
+    // have loaded, or after a rotation) keeps the zoom and visible region.
+    void setPage(const void *page, const cv::Mat &full, const cv::Mat &overview, int viewRotation);
+
+    // Drop the page and show a message instead
+    void showMessage(const QString &text);
+
+    void fitToWindow();
+    void zoomToActualSize();
+
+protected:
+    void wheelEvent(QWheelEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    friend class TiledPageItem;
+
+    static quint64 tileKey(int level, int column, int row);
+    static QRectF tileRect(quint64 key);
+
+    // Pixels for a tile if cached; otherwise queue it and return null
+    const QPixmap *tile(int level, int column, int row);
+    void startQueuedTiles();
+    bool tileVisible(quint64 key) const;
+    int currentLevel() const;
+    double fitZoom() const;
+    void zoomBy(double factor);
+    void clearTiles();
+
+    QGraphicsScene *pageScene;
+    TiledPageItem *item{nullptr};
+    QGraphicsSimpleTextItem *message{nullptr};
+    const void *page{nullptr};
+    cv::Mat full;               // shared with the page state; empty until loaded
+    cv::Mat overview;           // held so its pixels are not reused while converted
+    bool fitMode{true};         // refit on resize until the user zooms
+    uint64_t generation{0};     // bumped whenever `full` changes; stale tiles are dropped
+
+    QCache<quint64, QPixmap> tiles;  // cost in KiB
+    QVector<quint64> queued;         // newest last; started newest first
+    QSet<quint64> inFlight;          // tiles of the current generation being rendered
+    int running{0};                  // render jobs on the pool, stale ones included
+};
@@ -0,0 +1,312 @@
+#include "pdf_writer.h"
+#include "Logger.hpp"
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <zlib.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Locale-independent decimal formatting (Qt calls setlocale() on Unix, which
+// would turn printf's decimal point into a comma in many locales).
+std::string formatReal(double value) {
+    const long long scaled = std::llround(value * 1000.0);
+    const long long whole = scaled / 1000;
+    long long frac = std::llabs(scaled % 1000);
+    std::string out = (scaled < 0 && whole == 0 ? "-" : "") + std::to_string(whole);
+    if (frac != 0) {
+        std::string digits = std::to_string(frac);
+        digits.insert(0, 3 - digits.size(), '0');
+        while (!digits.empty() && digits.back() == '0')
+            digits.pop_back();
+        out += "." + digits;
+    }
+    return out;
+}
+
+unsigned readBE16(const unsigned char* p) {
+    return (static_cast<unsigned>(p[0]) << 8) | p[1];
+}
+
+// EXIF orientation from an APP1 payload (after the marker length), 1 if absent.
+int exifOrientation(const unsigned char* seg, size_t len) {
+    if (len < 14 || std::memcmp(seg, "Exif\0\0", 6) != 0)
+        return 1;
+    const unsigned char* tiff = seg + 6;
+    const size_t tiffLen = len - 6;
+    const bool little = tiff[0] == 'I' && tiff[1] == 'I';
+    if (!little && !(tiff[0] == 'M' && tiff[1] == 'M'))
+        return 1;
+    auto u16 = [&](size_t at) -> unsigned {
+        return little ? (tiff[at] | (tiff[at + 1] << 8)) : ((tiff[at] << 8) | tiff[at + 1]);
+    };
+    auto u32 = [&](size_t at) -> size_t {
+        return little
+            ? (static_cast<size_t>(tiff[at]) | (static_cast<size_t>(tiff[at + 1]) << 8)
+               | (static_cast<size_t>(tiff[at + 2]) << 16) | (static_cast<size_t>(tiff[at + 3]) << 24))
+            : ((static_cast<size_t>(tiff[at]) << 24) | (static_cast<size_t>(tiff[at + 1]) << 16)
+               | (static_cast<size_t>(tiff[at + 2]) << 8) | static_cast<size_t>(tiff[at + 3]));
+    };
+    const size_t ifd = u32(4);
+    if (ifd + 2 > tiffLen)
+        return 1;
+    const unsigned entries = u16(ifd);
+    for (unsigned i = 0; i < entries; ++i) {
+        const size_t entry = ifd + 2 + 12 * static_cast<size_t>(i);
+        if (entry + 12 > tiffLen)
+            break;
+        if (u16(entry) == 0x0112)
+            return static_cast<int>(u16(entry + 8));
+    }
+    return 1;
+}
+
+struct JpegInfo {
+    int width{0};
+    int height{0};
+    int components{0};
+    int orientation{1};
+};
+
+// Scan JPEG markers up to the first scan for frame size and EXIF orientation.
+// Only baseline/extended/progressive Huffman frames are accepted.
+bool parseJpeg(const std::vector<unsigned char>& data, JpegInfo& info) {
+    const size_t n = data.size();
+    if (n < 4 || data[0] != 0xFF || data[1] != 0xD8)
+        return false;
+    size_t pos = 2;
+    while (pos + 4 <= n) {
+        if (data[pos] != 0xFF)
+            return false;
+        const unsigned char marker = data[pos + 1];
+        if (marker == 0xFF) {  // fill byte
+            ++pos;
+            continue;
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+            pos += 2;
+            continue;
+        }
+        const size_t len = readBE16(&data[pos + 2]);
+        if (len < 2 || pos + 2 + len > n)
+            return false;
+        const unsigned char* seg = &data[pos + 4];
+        if (marker == 0xC0 || marker == 0xC1 || marker == 0xC2) {
+            if (len < 8 || seg[0] != 8)
+                return false;
+            info.height = static_cast<int>(readBE16(seg + 1));
+            info.width = static_cast<int>(readBE16(seg + 3));
+            info.components = seg[5];
+        } else if ((marker >= 0xC3 && marker <= 0xCF) && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            return false;  // lossless/arithmetic frames: not safe for DCTDecode
+        } else if (marker == 0xE1) {
+            info.orientation = exifOrientation(seg, len - 2);
+        } else if (marker == 0xDA) {
+            break;  // start of scan: all headers seen
+        }
+        pos += 2 + len;
+    }
+    return info.width > 0 && info.height > 0;
+}
+
+bool isBilevel(const cv::Mat& gray) {
+    for (int y = 0; y < gray.rows; ++y) {
+        const unsigned char* row = gray.ptr<unsigned char>(y);
+        for (int x = 0; x < gray.cols; ++x) {
+            if (row[x] != 0 && row[x] != 255)
+                return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+PdfWriter::~PdfWriter() {
+    if (file)
+        close();
+}
+
+bool PdfWriter::open(const std::string& path) {
+    if (file)
+        close();
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        Logger::error("PdfWriter: cannot open ", path);
+        return false;
+    }
+    offset = 0;
+    failed = false;
+    objectOffsets.clear();
+    pageIds.clear();
+    // Binary comment marks the file as binary for transfer tools
+    write("%PDF-1.4\n%\xE2\xE3\xCF\xD3\n");
+    reserveObject();            // 1: catalog, written by close()
+    pagesId = reserveObject();  // 2: page tree, written by close()
+    return !failed;
+}
+
+bool PdfWriter::addImagePage(const cv::Mat& image, double dpi, int jpegQuality) {
+    if (!file || image.empty() || image.depth() != CV_8U)
+        return false;
+
+    ImageStream stream;
+    stream.width = image.cols;
+    stream.height = image.rows;
+
+    if (image.channels() == 1 && isBilevel(image)) {
+        // 1-bit DeviceGray: bit set = white. Rows are padded to whole bytes.
+        const size_t rowBytes = (static_cast<size_t>(image.cols) + 7) / 8;
+        std::vector<unsigned char> packed(rowBytes * image.rows, 0);
+        for (int y = 0; y < image.rows; ++y) {
+            const unsigned char* src = image.ptr<unsigned char>(y);
+            unsigned char* dst = &packed[rowBytes * y];
+            for (int x = 0; x < image.cols; ++x) {
+                if (src[x])
+                    dst[x >> 3] |= static_cast<unsigned char>(0x80u >> (x & 7));
+            }
+        }
+        uLongf compressedSize = compressBound(static_cast<uLong>(packed.size()));
+        std::vector<unsigned char> compressed(compressedSize);
+        if (compress2(compressed.data(), &compressedSize, packed.data(),
+                      static_cast<uLong>(packed.size()), Z_BEST_COMPRESSION) != Z_OK) {
+            Logger::error("PdfWriter: Flate compression failed");
+            return false;
+        }
+        stream.components = 1;
+        stream.bitsPerComponent = 1;
+        stream.filter = "FlateDecode";
+        stream.data = compressed.data();
+        stream.size = compressedSize;
+        return writePage(stream, dpi);
+    }
+
+    cv::Mat encodable = image;
+    if (image.channels() == 4)
+        cv::cvtColor(image, encodable, cv::COLOR_BGRA2BGR);
+    std::vector<unsigned char> jpeg;
+    if (!cv::imencode(".jpg", encodable, jpeg, {cv::IMWRITE_JPEG_QUALITY, jpegQuality})) {
+        Logger::error("PdfWriter: JPEG encoding failed");
+        return false;
+    }
+    stream.components = encodable.channels() == 1 ? 1 : 3;
+    stream.filter = "DCTDecode";
+    stream.data = jpeg.data();
+    stream.size = jpeg.size();
+    return writePage(stream, dpi);
+}
+
+bool PdfWriter::addJpegPassthroughPage(const std::vector<unsigned char>& jpeg, double dpi) {
+    if (!file)
+        return false;
+    JpegInfo info;
+    if (!parseJpeg(jpeg, info) || (info.components != 1 && info.components != 3) || info.orientation != 1)
+        return false;
+
+    ImageStream stream;
+    stream.width = info.width;
+    stream.height = info.height;
+    stream.components = info.components;
+    stream.filter = "DCTDecode";
+    stream.data = jpeg.data();
+    stream.size = jpeg.size();
+    return writePage(stream, dpi);
+}
+
+bool PdfWriter::writePage(const ImageStream& image, double dpi) {
+    const double pointsPerPixel = 72.0 / dpi;
+    const std::string pageWidth = formatReal(image.width * pointsPerPixel);
+    const std::string pageHeight = formatReal(image.height * pointsPerPixel);
+
+    const int imageId = beginObject();
+    write("<< /Type /XObject /Subtype /Image /Width " + std::to_string(image.width)
+          + " /Height " + std::to_string(image.height)
+          + (image.components == 1 ? " /ColorSpace /DeviceGray" : " /ColorSpace /DeviceRGB")
+          + " /BitsPerComponent " + std::to_string(image.bitsPerComponent)
+          + " /Filter /" + image.filter
+          + " /Length " + std::to_string(image.size) + " >>\nstream\n");
+    write(image.data, image.size);
+    write("\nendstream\nendobj\n");
+
+    const std::string content = "q\n" + pageWidth + " 0 0 " + pageHeight + " 0 0 cm\n/Im0 Do\nQ\n";
+    const int contentId = beginObject();
+    write("<< /Length " + std::to_string(content.size()) + " >>\nstream\n" + content + "endstream\nendobj\n");
+
+    const int pageId = beginObject();
+    write("<< /Type /Page /Parent " + std::to_string(pagesId) + " 0 R /MediaBox [0 0 "
+          + pageWidth + " " + pageHeight + "] /Resources << /XObject << /Im0 "
+          + std::to_string(imageId) + " 0 R >> >> /Contents " + std::to_string(contentId)
+          + " 0 R >>\nendobj\n");
+    pageIds.push_back(pageId);
+
+    // Push the page out now so nothing accumulates in stdio buffers
+    if (std::fflush(file) != 0)
+        failed = true;
+    if (failed)
+        Logger::error("PdfWriter: write failed");
+    return !failed;
+}
+
+bool PdfWriter::close() {
+    if (!file)
+        return false;
+
+    beginReservedObject(pagesId);
+    std::string kids;
+    for (int id : pageIds)
+        kids += std::to_string(id) + " 0 R ";
+    write("<< /Type /Pages /Kids [" + kids + "] /Count " + std::to_string(pageIds.size()) + " >>\nendobj\n");
+
+    beginReservedObject(1);
+    write("<< /Type /Catalog /Pages " + std::to_string(pagesId) + " 0 R >>\nendobj\n");
+
+    const size_t xrefOffset = offset;
+    write("xref\n0 " + std::to_string(objectOffsets.size() + 1) + "\n0000000000 65535 f \n");
+    for (size_t objOffset : objectOffsets) {
+        std::string entry = std::to_string(objOffset);
+        entry.insert(0, 10 - std::min<size_t>(10, entry.size()), '0');
+        write(entry + " 00000 n \n");
+    }
+    write("trailer\n<< /Size " + std::to_string(objectOffsets.size() + 1)
+          + " /Root 1 0 R >>\nstartxref\n" + std::to_string(xrefOffset) + "\n%%EOF\n");
+
+    if (std::fclose(file) != 0)
+        failed = true;
+    file = nullptr;
+    if (failed)
+        Logger::error("PdfWriter: failed to finish file");
+    return !failed;
+}
+
+int PdfWriter::beginObject() {
+    const int id = reserveObject();
+    beginReservedObject(id);
+    return id;
+}
+
+int PdfWriter::reserveObject() {
+    objectOffsets.push_back(0);
+    return static_cast<int>(objectOffsets.size());
+}
+
+void PdfWriter::beginReservedObject(int id) {
+    objectOffsets[static_cast<size_t>(id) - 1] = offset;
+    write(std::to_string(id) + " 0 obj\n");
+}
+
+bool PdfWriter::write(const std::string& text) {
+    return write(reinterpret_cast<const unsigned char*>(text.data()), text.size());
+}
+
+bool PdfWriter::write(const unsigned char* data, size_t size) {
+    if (failed || !file)
+        return false;
+    if (size > 0 && std::fwrite(data, 1, size, file) != size) {
+        failed = true;
+        return false;
+    }
+    offset += size;
+    return true;
+}
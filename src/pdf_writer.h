@@ -0,0 +1,84 @@
+#ifndef PDF_WRITER_H
+#define PDF_WRITER_H
+
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * Minimal streaming PDF writer for image-only documents.
+ *
+ * Each page is one full-bleed image. Page objects are written to disk as soon
+ * as they are added, so memory use is bounded by a single page regardless of
+ * document length; the page tree and cross-reference table are written by
+ * close(). Images are embedded without re-rasterization:
+ *  - color/gray pages as DCT (JPEG) streams, optionally passed through
+ *    verbatim from an existing JPEG file,
+ *  - pure black/white pages as 1-bit Flate-compressed streams.
+ *
+ * Errors are reported by return value and logged; after a failure the writer
+ * should be closed and the partial file discarded.
+ */
+class PdfWriter {
+public:
+    PdfWriter() = default;
+    ~PdfWriter();
+    PdfWriter(const PdfWriter&) = delete;
+    PdfWriter& operator=(const PdfWriter&) = delete;
+
+    /** Create (truncate) the output file and write the header. */
+    bool open(const std::string& path);
+
+    /**
+     * Add a page from an 8-bit gray, BGR or BGRA image. Gray images containing
+     * only 0 and 255 are stored as 1-bit Flate; everything else as JPEG.
+     *
+     * @param dpi         Resolution used to derive the page size in points.
+     * @param jpegQuality JPEG quality (0-100) for DCT-encoded pages.
+     */
+    bool addImagePage(const cv::Mat& image, double dpi, int jpegQuality = 90);
+
+    /**
+     * Add a page by embedding an existing JPEG file's bytes unchanged.
+     *
+     * Returns false without writing anything if the data is not a gray or
+     * YCbCr/RGB JPEG, or if its EXIF orientation is not upright (PDF viewers
+     * ignore EXIF, so such pages must be decoded and re-encoded instead).
+     */
+    bool addJpegPassthroughPage(const std::vector<unsigned char>& jpeg, double dpi);
+
+    /** Write the page tree, catalog, xref and trailer and close the file. */
+    bool close();
+
+    bool isOpen() const { return file != nullptr; }
+    int pageCount() const { return static_cast<int>(pageIds.size()); }
+
+private:
+    struct ImageStream {
+        int width{0};
+        int height{0};
+        int components{1};     // 1 = DeviceGray, 3 = DeviceRGB
+        int bitsPerComponent{8};
+        const char* filter{nullptr};  // "DCTDecode" or "FlateDecode"
+        const unsigned char* data{nullptr};
+        size_t size{0};
+    };
+
+    bool writePage(const ImageStream& image, double dpi);
+    int beginObject();
+    int reserveObject();
+    void beginReservedObject(int id);
+    bool write(const std::string& text);
+    bool write(const unsigned char* data, size_t size);
+
+    std::FILE* file{nullptr};
+    size_t offset{0};                 // bytes written so far
+    std::vector<size_t> objectOffsets;  // index = object id - 1
+    std::vector<int> pageIds;
+    int pagesId{0};
+    bool failed{false};
+};
+
+#endif // PDF_WRITER_H
@@ -0,0 +1,420 @@
+#include "session_file.h"
+#include "Logger.hpp"
+#include "trace.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <type_traits>
+
+#if defined(_WIN32)
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace cv;
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+
+// Layout:
+//   header (64 bytes): magic, version, byte-order mark, page count,
+//                      page table offset and size
+//   pixel blocks:      raw rows, each block starting on a 64-byte boundary
+//   page table:        per page the source path and fingerprint, the edit
+//                      steps, the location of both pixel blocks and flags
+constexpr char kMagic[8] = {'P', 'X', 'S', 'E', 'S', 'S', 'N', '1'};
+constexpr uint32_t kVersion = 2;
+constexpr uint32_t kFlagsVersion = 2;  // version 1 records end after the pixel blocks
+constexpr uint32_t kPageAutoSnapTried = 1u << 0;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+constexpr size_t kHeaderSize = 64;
+constexpr size_t kPixelAlignment = 64;
+constexpr size_t kSampleBytes = 64 * 1024;
+// Smallest page table record: empty path, fingerprint, no edits, applied
+// step count, two pixel block descriptors and the flags
+constexpr size_t kMinPageRecordBytes = sizeof(uint32_t) + sizeof(uint64_t) + sizeof(int64_t) + sizeof(uint64_t)
+    + sizeof(uint32_t) + sizeof(uint32_t) + 2 * (sizeof(uint64_t) + 3 * sizeof(int32_t)) + sizeof(uint32_t);
+constexpr uint64_t kFnvOffset = 1469598103934665603ull;
+constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+uint64_t fnv1a(uint64_t hash, const unsigned char* bytes, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        hash ^= bytes[i];
+        hash *= kFnvPrime;
+    }
+    return hash;
+}
+
+// Appends native-endian scalars; the header's byte-order mark rejects files
+// written on a machine of the other endianness
+class TableWriter {
+public:
+    template <typename T>
+    void put(T value) {
+        static_assert(is_trivially_copyable_v<T>, "scalars only");
+        const auto* bytes = reinterpret_cast<const unsigned char*>(&value);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    void putString(const string& text) {
+        put(static_cast<uint32_t>(text.size()));
+        buffer.insert(buffer.end(), text.begin(), text.end());
+    }
+
+    vector<unsigned char> buffer;
+};
+
+class TableReader {
+public:
+    TableReader(const unsigned char* data, size_t size) : data(data), size(size) {}
+
+    template <typename T>
+    bool get(T& value) {
+        if (size - pos < sizeof(T))
+            return false;
+        memcpy(&value, data + pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    bool getString(string& text) {
+        uint32_t length = 0;
+        if (!get(length) || size - pos < length)
+            return false;
+        text.assign(reinterpret_cast<const char*>(data + pos), length);
+        pos += length;
+        return true;
+    }
+
+private:
+    const unsigned char* data;
+    size_t size;
+    size_t pos{0};
+};
+
+struct PixelBlock {
+    uint64_t offset{0};
+    int32_t cols{0};
+    int32_t rows{0};
+    int32_t type{0};
+};
+
+void putEdit(TableWriter& table, const EditOp& op) {
+    table.put(static_cast<int32_t>(op.kind));
+    table.put(static_cast<int32_t>(op.angle));
+    table.put(static_cast<uint32_t>(op.corners.size()));
+    for (const Point2f& p : op.corners) {
+        table.put(p.x);
+        table.put(p.y);
+    }
+    table.put(op.crop.x);
+    table.put(op.crop.y);
+    table.put(op.crop.width);
+    table.put(op.crop.height);
+    table.put(static_cast<int32_t>(op.binarization.method));
+    table.put(op.binarization.k);
+    table.put(static_cast<int32_t>(op.binarization.windowSize));
+    table.put(op.gain);
+    table.put(op.bias);
+}
+
+bool getEdit(TableReader& table, EditOp& op) {
+    int32_t kind = 0, angle = 0, method = 0, windowSize = 0;
+    uint32_t cornerCount = 0;
+    if (!table.get(kind) || kind < 0 || kind > static_cast<int32_t>(EditKind::ColorCorrect)
+            || !table.get(angle) || !table.get(cornerCount) || cornerCount > 4)
+        return false;
+    op.kind = static_cast<EditKind>(kind);
+    op.angle = angle;
+    op.corners.resize(cornerCount);
+    for (Point2f& p : op.corners) {
+        if (!table.get(p.x) || !table.get(p.y))
+            return false;
+    }
+    if (!table.get(op.crop.x) || !table.get(op.crop.y) || !table.get(op.crop.width) || !table.get(op.crop.height)
+            || !table.get(method) || !table.get(op.binarization.k) || !table.get(windowSize)
+            || !table.get(op.gain) || !table.get(op.bias))
+        return false;
+    op.binarization.method = method == static_cast<int32_t>(BinarizationMethod::Wolf)
+        ? BinarizationMethod::Wolf : BinarizationMethod::Sauvola;
+    op.binarization.windowSize = windowSize;
+    return true;
+}
+
+// Writes pixel blocks at aligned offsets and tracks the file position
+class PixelWriter {
+public:
+    explicit PixelWriter(FILE* file) : file(file) {}
+
+    bool write(const Mat& image, PixelBlock& block) {
+        block = PixelBlock();
+        if (image.empty())
+            return true;
+        static const unsigned char zeros[kPixelAlignment] = {};
+        const size_t padding = (kPixelAlignment - offset % kPixelAlignment) % kPixelAlignment;
+        if (!writeBytes(zeros, padding))
+            return false;
+        block.offset = offset;
+        block.cols = image.cols;
+        block.rows = image.rows;
+        block.type = image.type();
+        const size_t rowBytes = static_cast<size_t>(image.cols) * image.elemSize();
+        for (int y = 0; y < image.rows; ++y) {
+            if (!writeBytes(image.ptr<unsigned char>(y), rowBytes))
+                return false;
+        }
+        return true;
+    }
+
+    bool writeBytes(const void* bytes, size_t count) {
+        if (count > 0 && fwrite(bytes, 1, count, file) != count)
+            return false;
+        offset += count;
+        return true;
+    }
+
+    uint64_t position() const { return offset; }
+
+private:
+    FILE* file;
+    uint64_t offset{0};
+};
+
+void putBlock(TableWriter& table, const PixelBlock& block) {
+    table.put(block.offset);
+    table.put(block.cols);
+    table.put(block.rows);
+    table.put(block.type);
+}
+
+// Only 8-bit pixels are stored; anything else is skipped
+Mat storablePixels(const Mat& image, int maxSide) {
+    if (image.empty() || image.depth() != CV_8U)
+        return Mat();
+    const int longSide = max(image.cols, image.rows);
+    if (longSide <= maxSide)
+        return image;
+    const double scale = static_cast<double>(maxSide) / longSide;
+    Mat scaled;
+    resize(image, scaled, Size(max(1, cvRound(image.cols * scale)), max(1, cvRound(image.rows * scale))),
+           0, 0, INTER_AREA);
+    return scaled;
+}
+
+} // namespace
+
+SourceFingerprint fingerprintFile(const string& path, bool withContentHash) {
+    SourceFingerprint fingerprint;
+    error_code ec;
+    const uintmax_t size = fs::file_size(path, ec);
+    if (ec)
+        return fingerprint;
+    const auto modified = fs::last_write_time(path, ec);
+    if (ec)
+        return fingerprint;
+    fingerprint.size = size;
+    fingerprint.modified = static_cast<int64_t>(modified.time_since_epoch().count());
+    if (!withContentHash)
+        return fingerprint;
+
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file)
+        return SourceFingerprint();
+    vector<unsigned char> sample(kSampleBytes);
+    uint64_t hash = fnv1a(kFnvOffset, reinterpret_cast<const unsigned char*>(&fingerprint.size),
+                          sizeof(fingerprint.size));
+    size_t got = fread(sample.data(), 1, sample.size(), file);
+    hash = fnv1a(hash, sample.data(), got);
+    if (size > 2 * kSampleBytes && fseek(file, -static_cast<long>(kSampleBytes), SEEK_END) == 0) {
+        got = fread(sample.data(), 1, sample.size(), file);
+        hash = fnv1a(hash, sample.data(), got);
+    }
+    fclose(file);
+    fingerprint.contentHash = hash;
+    return fingerprint;
+}
+
+bool sourceUnchanged(const string& path, const SourceFingerprint& recorded) {
+    const SourceFingerprint quick = fingerprintFile(path, false);
+    if (quick.size == 0 || quick.size != recorded.size)
+        return false;
+    if (quick.modified == recorded.modified)
+        return true;
+    // Touched (copied, restored from backup) but possibly the same bytes
+    return fingerprintFile(path, true).contentHash == recorded.contentHash;
+}
+
+bool writeSession(const string& path, const vector<SessionPage>& pages) {
+    TraceSpan span("writeSession");
+    const string tempPath = path + ".tmp";
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (!file) {
+        Logger::error("writeSession: cannot open ", tempPath);
+        return false;
+    }
+
+    PixelWriter pixels(file);
+    unsigned char header[kHeaderSize] = {};
+    bool ok = pixels.writeBytes(header, sizeof(header));  // filled in last
+
+    TableWriter table;
+    for (const SessionPage& page : pages) {
+        if (!ok)
+            break;
+        PixelBlock thumbnail, preview;
+        ok = pixels.write(storablePixels(page.thumbnail, INT32_MAX), thumbnail)
+          && pixels.write(storablePixels(page.preview, kSessionPreviewSize), preview);
+        table.putString(page.sourcePath);
+        table.put(page.source.size);
+        table.put(page.source.modified);
+        table.put(page.source.contentHash);
+        table.put(static_cast<uint32_t>(page.edits.size()));
+        for (const EditOp& op : page.edits)
+            putEdit(table, op);
+        table.put(static_cast<uint32_t>(min(page.appliedSteps, page.edits.size())));
+        putBlock(table, thumbnail);
+        putBlock(table, preview);
+        table.put(page.autoSnapTried ? kPageAutoSnapTried : 0u);
+    }
+
+    const uint64_t tableOffset = pixels.position();
+    const uint64_t tableSize = table.buffer.size();
+    ok = ok && pixels.writeBytes(table.buffer.data(), table.buffer.size());
+
+    // Header last: a file cut short never carries a valid page table
+    const uint32_t pageCount = static_cast<uint32_t>(pages.size());
+    memcpy(header, kMagic, sizeof(kMagic));
+    memcpy(header + 8, &kVersion, 4);
+    memcpy(header + 12, &kByteOrderMark, 4);
+    memcpy(header + 16, &pageCount, 4);
+    memcpy(header + 24, &tableOffset, 8);
+    memcpy(header + 32, &tableSize, 8);
+    ok = ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(header, 1, sizeof(header), file) == sizeof(header);
+    ok = (fclose(file) == 0) && ok;
+
+    error_code ec;
+    if (ok)
+        fs::rename(tempPath, path, ec);
+    if (!ok || ec) {
+        Logger::error("writeSession: failed to write ", path);
+        fs::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+SessionFile::~SessionFile() {
+#if !defined(_WIN32)
+    if (data && heapCopy.empty())
+        munmap(const_cast<unsigned char*>(data), size);
+#endif
+}
+
+shared_ptr<const SessionFile> SessionFile::open(const string& path) {
+    TraceSpan span("openSession");
+    shared_ptr<SessionFile> session(new SessionFile());
+#if defined(_WIN32)
+    ifstream in(path, ios::binary);
+    if (!in)
+        return nullptr;
+    session->heapCopy.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    session->data = session->heapCopy.data();
+    session->size = session->heapCopy.size();
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(kHeaderSize)) {
+        ::close(fd);
+        Logger::warn("SessionFile: ", path, " is not a session file");
+        return nullptr;
+    }
+    void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // the mapping stays valid
+    if (mapped == MAP_FAILED) {
+        Logger::error("SessionFile: cannot map ", path);
+        return nullptr;
+    }
+    session->data = static_cast<const unsigned char*>(mapped);
+    session->size = static_cast<size_t>(info.st_size);
+#endif
+    if (!session->parse()) {
+        Logger::warn("SessionFile: ", path, " is damaged or from another version");
+        return nullptr;
+    }
+    return session;
+}
+
+bool SessionFile::parse() {
+    if (size < kHeaderSize || memcmp(data, kMagic, sizeof(kMagic)) != 0)
+        return false;
+    uint32_t version = 0, byteOrder = 0, pageCount = 0;
+    uint64_t tableOffset = 0, tableSize = 0;
+    memcpy(&version, data + 8, 4);
+    memcpy(&byteOrder, data + 12, 4);
+    memcpy(&pageCount, data + 16, 4);
+    memcpy(&tableOffset, data + 24, 8);
+    memcpy(&tableSize, data + 32, 8);
+    if (version < 1 || version > kVersion || byteOrder != kByteOrderMark
+            || tableOffset > size || tableSize > size - tableOffset)
+        return false;
+
+    // Pixel blocks must lie inside the file, before the page table
+    auto view = [&](const PixelBlock& block, Mat& image) {
+        if (block.cols == 0 && block.rows == 0)
+            return true;
+        if (block.cols <= 0 || block.rows <= 0 || CV_MAT_DEPTH(block.type) != CV_8U)
+            return false;
+        const size_t rowBytes = static_cast<size_t>(block.cols) * CV_ELEM_SIZE(block.type);
+        if (block.offset > tableOffset || rowBytes * block.rows > tableOffset - block.offset)
+            return false;
+        image = Mat(block.rows, block.cols, block.type,
+                    const_cast<unsigned char*>(data + block.offset), rowBytes);
+        return true;
+    };
+
+    // The page count is only trusted as far as the table can hold that many
+    // records; a corrupt count must not turn into a huge allocation
+    const bool hasFlags = version >= kFlagsVersion;
+    const size_t minRecordBytes = hasFlags ? kMinPageRecordBytes : kMinPageRecordBytes - sizeof(uint32_t);
+    if (pageCount > tableSize / minRecordBytes)
+        return false;
+
+    TableReader table(data + tableOffset, static_cast<size_t>(tableSize));
+    pageList.resize(pageCount);
+    for (SessionPage& page : pageList) {
+        uint32_t editCount = 0, appliedSteps = 0, flags = 0;
+        if (!table.getString(page.sourcePath) || !table.get(page.source.size)
+                || !table.get(page.source.modified) || !table.get(page.source.contentHash)
+                || !table.get(editCount))
+            return false;
+        page.edits.resize(min<uint32_t>(editCount, 1024));
+        if (page.edits.size() != editCount)
+            return false;
+        for (EditOp& op : page.edits) {
+            if (!getEdit(table, op))
+                return false;
+        }
+        PixelBlock thumbnail, preview;
+        if (!table.get(appliedSteps) || appliedSteps > editCount
+                || !table.get(thumbnail.offset) || !table.get(thumbnail.cols) || !table.get(thumbnail.rows)
+                || !table.get(thumbnail.type)
+                || !table.get(preview.offset) || !table.get(preview.cols) || !table.get(preview.rows)
+                || !table.get(preview.type)
+                || !view(thumbnail, page.thumbnail) || !view(preview, page.preview)
+                || (hasFlags && !table.get(flags)))
+            return false;
+        page.appliedSteps = appliedSteps;
+        page.autoSnapTried = (flags & kPageAutoSnapTried) != 0;
+    }
+    return true;
+}
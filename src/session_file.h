@@ -0,0 +1,85 @@
+#ifndef SESSION_FILE_H
+#define SESSION_FILE_H
+
+#include "page_edits.h"
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Identity of a source image file. The content hash covers the file size
+ * and its first and last 64 KiB: enough to notice a replaced or re-exported
+ * photo without reading hundreds of megabytes when a session is reopened.
+ */
+struct SourceFingerprint {
+    uint64_t size{0};
+    int64_t modified{0};      // last write time, filesystem clock ticks
+    uint64_t contentHash{0};
+};
+
+/**
+ * Fingerprint a file; all zero if it cannot be read.
+ *
+ * @param withContentHash Also read the sampled content; size and time alone
+ *                        are a stat() call.
+ */
+SourceFingerprint fingerprintFile(const std::string& path, bool withContentHash = true);
+
+/** True if `path` still holds the content described by `recorded`. */
+bool sourceUnchanged(const std::string& path, const SourceFingerprint& recorded);
+
+/** One page of a session, in page order. */
+struct SessionPage {
+    std::string sourcePath;
+    SourceFingerprint source;
+    std::vector<EditOp> edits;  // includes detected snap corners
+    size_t appliedSteps{0};     // leading steps baked into the stored pixels
+    bool autoSnapTried{false};  // background snap ran or was declined; false in version 1 files
+    cv::Mat thumbnail;          // 8-bit display levels of the edited page
+    cv::Mat preview;
+};
+
+/**
+ * An opened session file.
+ *
+ * The file is memory-mapped: page metadata is parsed on open, but the stored
+ * thumbnail and preview pixels are cv::Mat headers pointing straight into the
+ * mapping and are only paged in when drawn. Those Mats do not own their
+ * pixels; keep the SessionFile alive for as long as any of them is used.
+ */
+class SessionFile {
+public:
+    ~SessionFile();
+    SessionFile(const SessionFile&) = delete;
+    SessionFile& operator=(const SessionFile&) = delete;
+
+    /** Map and parse a session file; null (and logged) if missing or invalid. */
+    static std::shared_ptr<const SessionFile> open(const std::string& path);
+
+    const std::vector<SessionPage>& pages() const { return pageList; }
+
+private:
+    SessionFile() = default;
+    bool parse();
+
+    const unsigned char* data{nullptr};
+    size_t size{0};
+    std::vector<unsigned char> heapCopy;  // used where mmap is unavailable
+    std::vector<SessionPage> pageList;
+};
+
+/** Long side of the stored preview level; larger previews are downscaled. */
+constexpr int kSessionPreviewSize = 512;
+
+/**
+ * Write a session file. Pixels are stored uncompressed and 64-byte aligned
+ * so SessionFile can map them; metadata follows in a page table at the end.
+ * The file is written next to `path` and renamed over it, so an existing
+ * session (even one currently mapped) is never left half-written.
+ */
+bool writeSession(const std::string& path, const std::vector<SessionPage>& pages);
+
+#endif // SESSION_FILE_H
@@ -0,0 +1,144 @@
+#include "trace.h"
+#include "Logger.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct TraceEvent {
+    const char* name;
+    int page;
+    int64_t startUs;
+    int64_t durationUs;
+};
+
+// Spans of one thread. Only the owning thread appends, so its mutex is
+// uncontended except while the trace is being written.
+struct ThreadTrace {
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+    const char* name{nullptr};
+    int id{0};
+};
+
+class TraceRecorder {
+public:
+    TraceRecorder() : epoch(Clock::now()) {
+        if (const char* env = std::getenv("PIXLSCAN_TRACE"); env && *env)
+            path = env;
+    }
+
+    ~TraceRecorder() {
+        if (!path.empty() && writeChromeTrace(path))
+            Logger::info("Trace written to ", path);
+    }
+
+    bool enabled() const { return !path.empty(); }
+
+    int64_t nowUs() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - epoch).count();
+    }
+
+    ThreadTrace& local() {
+        thread_local std::shared_ptr<ThreadTrace> trace;
+        if (!trace) {
+            trace = std::make_shared<ThreadTrace>();
+            std::lock_guard<std::mutex> lock(mutex);
+            trace->id = static_cast<int>(threads.size()) + 1;
+            threads.push_back(trace);
+        }
+        return *trace;
+    }
+
+    // Buffers stay alive here even after their thread exits
+    std::vector<std::shared_ptr<ThreadTrace>> snapshot() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return threads;
+    }
+
+private:
+    Clock::time_point epoch;
+    std::string path;
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadTrace>> threads;
+};
+
+TraceRecorder& recorder() {
+    static TraceRecorder instance;
+    return instance;
+}
+
+} // namespace
+
+bool traceEnabled() {
+    static const bool enabled = recorder().enabled();
+    return enabled;
+}
+
+void setTraceThreadName(const char* name) {
+    if (!traceEnabled())
+        return;
+    ThreadTrace& trace = recorder().local();
+    std::lock_guard<std::mutex> lock(trace.mutex);
+    trace.name = name;
+}
+
+TraceSpan::TraceSpan(const char* name, int page)
+    : name(traceEnabled() ? name : nullptr), page(page) {
+    if (this->name)
+        startUs = recorder().nowUs();
+}
+
+TraceSpan::~TraceSpan() {
+    if (!name)
+        return;
+    TraceRecorder& rec = recorder();
+    const int64_t endUs = rec.nowUs();
+    ThreadTrace& trace = rec.local();
+    std::lock_guard<std::mutex> lock(trace.mutex);
+    trace.events.push_back({name, page, startUs, endUs - startUs});
+}
+
+bool writeChromeTrace(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        Logger::error("writeChromeTrace: cannot open ", path);
+        return false;
+    }
+
+    // Complete ("X") events plus thread-name metadata; stage names are
+    // string literals and need no escaping
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+    bool first = true;
+    auto separator = [&]() {
+        if (!first)
+            std::fputs(",\n", file);
+        first = false;
+    };
+    for (const auto& trace : recorder().snapshot()) {
+        std::lock_guard<std::mutex> lock(trace->mutex);
+        if (trace->name) {
+            separator();
+            std::fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                               "\"args\":{\"name\":\"%s\"}}", trace->id, trace->name);
+        }
+        for (const TraceEvent& event : trace->events) {
+            separator();
+            std::fprintf(file, "{\"name\":\"%s\",\"cat\":\"pixlscan\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                               "\"ts\":%lld,\"dur\":%lld",
+                         event.name, trace->id, static_cast<long long>(event.startUs),
+                         static_cast<long long>(event.durationUs));
+            if (event.page >= 0)
+                std::fprintf(file, ",\"args\":{\"page\":%d}", event.page);
+            std::fputc('}', file);
+        }
+    }
+    std::fputs("\n]}\n", file);
+    return std::fclose(file) == 0;
+}
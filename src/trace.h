@@ -0,0 +1,47 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Scoped timing spans, written as a Chrome trace for chrome://tracing or
+ * ui.perfetto.dev.
+ *
+ * Tracing is off unless PIXLSCAN_TRACE names an output file. Then each span
+ * records its stage name, page index, thread and duration into a buffer owned
+ * by the recording thread, and all buffers are written as one JSON file when
+ * the process exits. A disabled span costs a cached flag check.
+ */
+bool traceEnabled();
+
+/**
+ * Label the calling thread in the trace, e.g. "GUI". `name` must stay valid
+ * for the life of the process (a string literal).
+ */
+void setTraceThreadName(const char* name);
+
+/** Write all spans recorded so far; false if the file cannot be written. */
+bool writeChromeTrace(const std::string& path);
+
+/**
+ * Records the time from construction to destruction as one trace event.
+ *
+ * @param name  Stage name; must be a string literal.
+ * @param page  Page index shown in the event's args, or -1 for none.
+ */
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name, int page = -1);
+    ~TraceSpan();
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* name;  // null when tracing is off
+    int page;
+    int64_t startUs{0};
+};
+
+#endif // TRACE_H
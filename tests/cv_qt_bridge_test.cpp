@@ -0,0 +1,128 @@
+// Checks that matToQImage() wraps a Mat's pixels instead of copying them:
+// the image must point at the Mat's buffer, read rows through the Mat's
+// stride and hold a reference to the buffer exactly as long as it lives.
+#include "cv_qt_bridge.h"
+#include <QColor>
+#include <QImage>
+#include <QtGlobal>
+#include <opencv2/core.hpp>
+#include <cstdio>
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(cond)                                                          \
+    do {                                                                     \
+        if (!(cond)) {                                                       \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,     \
+                         __LINE__, #cond);                                   \
+            ++failures;                                                      \
+        }                                                                    \
+    } while (0)
+
+int refcount(const cv::Mat &mat)
+{
+    return mat.u ? mat.u->refcount : 0;
+}
+
+// The image shares the Mat's pixels and row stride
+void checkWrapped(const cv::Mat &mat, const QImage &image)
+{
+    CHECK(!image.isNull());
+    CHECK(image.constBits() == mat.data);
+    CHECK(image.width() == mat.cols);
+    CHECK(image.height() == mat.rows);
+    CHECK(image.bytesPerLine() == static_cast<int>(mat.step));
+}
+
+void testGray()
+{
+    cv::Mat mat(32, 48, CV_8UC1, cv::Scalar(0));
+    mat.at<uchar>(5, 7) = 200;
+    const QImage image = matToQImage(mat);
+    checkWrapped(mat, image);
+    CHECK(image.format() == QImage::Format_Grayscale8);
+    CHECK(qGray(image.pixel(7, 5)) == 200);
+}
+
+void testBgr()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    cv::Mat mat(32, 48, CV_8UC3, cv::Scalar(10, 20, 30));  // B, G, R
+    const QImage image = matToQImage(mat);
+    checkWrapped(mat, image);
+    CHECK(image.format() == QImage::Format_BGR888);
+    CHECK(image.pixelColor(3, 4) == QColor(30, 20, 10));
+#endif
+}
+
+void testBgra()
+{
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    cv::Mat mat(32, 48, CV_8UC4, cv::Scalar(10, 20, 30, 255));
+    const QImage image = matToQImage(mat);
+    checkWrapped(mat, image);
+    CHECK(image.format() == QImage::Format_ARGB32);
+    CHECK(image.pixelColor(3, 4) == QColor(30, 20, 10, 255));
+#endif
+}
+
+// A ROI is not continuous: its rows are the parent's stride apart
+void testRoi()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    cv::Mat parent(80, 100, CV_8UC3, cv::Scalar(0, 0, 0));
+    const cv::Mat roi = parent(cv::Rect(10, 5, 30, 20));
+    CHECK(!roi.isContinuous());
+    roi.at<cv::Vec3b>(19, 29) = cv::Vec3b(1, 2, 3);
+    const QImage image = matToQImage(roi);
+    checkWrapped(roi, image);
+    CHECK(image.pixelColor(29, 19) == QColor(3, 2, 1));
+    CHECK(image.pixelColor(0, 0) == QColor(0, 0, 0));
+#endif
+}
+
+// The image holds one reference to the buffer, shared by its copies and
+// dropped with the last of them
+void testLifetime()
+{
+    cv::Mat mat(16, 16, CV_8UC1, cv::Scalar(0));
+    CHECK(refcount(mat) == 1);
+    {
+        QImage image = matToQImage(mat);
+        CHECK(refcount(mat) == 2);
+        {
+            const QImage copy = image;
+            CHECK(refcount(mat) == 2);
+        }
+        image = QImage();
+        CHECK(refcount(mat) == 1);
+    }
+    CHECK(refcount(mat) == 1);
+
+    // The image alone keeps the pixels alive once the Mat is gone
+    QImage survivor;
+    {
+        cv::Mat temporary(16, 16, CV_8UC1, cv::Scalar(77));
+        survivor = matToQImage(temporary);
+    }
+    CHECK(qGray(survivor.pixel(8, 8)) == 77);
+}
+
+} // namespace
+
+int main()
+{
+    testGray();
+    testBgr();
+    testBgra();
+    testRoi();
+    testLifetime();
+    if (failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("cv_qt_bridge_test: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,150 @@
+// Checks edit list bookkeeping (rotation merging, prefix replacement,
+// hashing) and that evaluation reuses cached prefixes and folds rotations
+// after a snap into its warp.
+#include "page_edits.h"
+#include <opencv2/core.hpp>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(cond)                                                          \
+    do {                                                                     \
+        if (!(cond)) {                                                       \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,     \
+                         __LINE__, #cond);                                   \
+            ++failures;                                                      \
+        }                                                                    \
+    } while (0)
+
+const std::vector<cv::Point2f> kCorners = {{0.1f, 0.1f}, {0.9f, 0.15f}, {0.85f, 0.9f}, {0.1f, 0.85f}};
+
+cv::Mat makeSource()
+{
+    cv::Mat source(60, 80, CV_8UC3);
+    cv::randu(source, cv::Scalar::all(0), cv::Scalar::all(256));
+    return source;
+}
+
+void testRotateMerging()
+{
+    PageEdits edits;
+    edits.rotate(90);
+    edits.rotate(90);
+    CHECK(edits.size() == 1);
+    CHECK(edits.ops()[0].angle == 180);
+
+    // A full turn removes the step
+    edits.rotate(180);
+    CHECK(edits.empty());
+
+    edits.rotate(-90);
+    CHECK(edits.size() == 1 && edits.ops()[0].angle == 270);
+    edits.rotate(0);
+    CHECK(edits.size() == 1);
+
+    // Only a trailing rotation merges
+    edits.push(EditOp::colorCorrect(1.5, 10.0));
+    edits.rotate(90);
+    CHECK(edits.size() == 3);
+    CHECK(edits.displayLength() == 2);
+    CHECK(edits.trailingRotation() == 90);
+}
+
+void testReplacePrefix()
+{
+    PageEdits edits;
+    edits.push(EditOp::snap());
+    edits.rotate(90);
+    edits.replacePrefix(1, {EditOp::snap(kCorners)});
+    CHECK(edits.size() == 2);
+    CHECK(edits.ops()[0].kind == EditKind::Snap && edits.ops()[0].corners.size() == 4);
+    CHECK(edits.ops()[1].kind == EditKind::Rotate && edits.ops()[1].angle == 90);
+
+    // A count past the end replaces the whole list
+    edits.replacePrefix(5, {EditOp::colorCorrect(2.0, 0.0)});
+    CHECK(edits.size() == 1 && edits.ops()[0].kind == EditKind::ColorCorrect);
+}
+
+void testHashing()
+{
+    const std::vector<EditOp> a = {EditOp::snap(kCorners), EditOp::rotate(90), EditOp::colorCorrect(1.2, 5.0)};
+    const std::vector<EditOp> b = {EditOp::snap(kCorners), EditOp::rotate(450), EditOp::colorCorrect(1.2, 5.0)};
+    CHECK(hashEditPrefix(a, a.size()) == hashEditPrefix(b, b.size()));
+
+    // Fields the kind does not use never matter
+    std::vector<EditOp> c = a;
+    c[2].angle = 180;
+    CHECK(hashEditPrefix(a, a.size()) == hashEditPrefix(c, c.size()));
+
+    std::vector<EditOp> d = a;
+    d[0].corners[2].x = 0.8f;
+    CHECK(hashEditPrefix(a, a.size()) != hashEditPrefix(d, d.size()));
+    CHECK(hashEditPrefix(a, 1) != hashEditPrefix(a, 2));
+    CHECK(hashEditPrefix(a, 2) == hashEditPrefix(c, 2));
+}
+
+void testCachedPrefix()
+{
+    const cv::Mat source = makeSource();
+    EditCache cache;
+    std::vector<EditOp> ops = {EditOp::cropTo(cv::Rect2f(0.1f, 0.1f, 0.8f, 0.8f)),
+                               EditOp::colorCorrect(1.2, 5.0), EditOp::rotate(90)};
+    const EditEvaluation first = evaluateEdits(source, ops, ops.size(), &cache);
+    CHECK(first.cachedSteps == 0);
+    CHECK(first.failedSteps == 0);
+    CHECK(first.resolved.size() == 3);
+
+    // Changing the last step re-evaluates only that step
+    ops.back() = EditOp::rotate(180);
+    const EditEvaluation changed = evaluateEdits(source, ops, ops.size(), &cache);
+    CHECK(changed.cachedSteps == 2);
+    CHECK(changed.image.size() == cv::Size(first.image.rows, first.image.cols));
+
+    const EditEvaluation again = evaluateEdits(source, ops, ops.size(), &cache);
+    CHECK(again.cachedSteps == 3);
+    CHECK(again.image.data == changed.image.data);
+
+    // Another source size never hits the same entries
+    const cv::Mat smaller = source(cv::Rect(0, 0, 40, 30));
+    CHECK(evaluateEdits(smaller, ops, ops.size(), &cache).cachedSteps == 0);
+}
+
+void testSnapFoldsRotation()
+{
+    const cv::Mat source = makeSource();
+    const std::vector<EditOp> snapOnly = {EditOp::snap(kCorners)};
+    const cv::Mat snapped = evaluateEdits(source, snapOnly, snapOnly.size()).image;
+    CHECK(!snapped.empty());
+
+    EditCache cache;
+    const std::vector<EditOp> ops = {EditOp::snap(kCorners), EditOp::rotate(90), EditOp::rotate(180)};
+    const EditEvaluation folded = evaluateEdits(source, ops, ops.size(), &cache);
+    CHECK(folded.failedSteps == 0);
+    CHECK(folded.resolved.size() == 3);
+    CHECK(folded.image.size() == cv::Size(snapped.rows, snapped.cols));
+
+    // The unrotated snap is never produced, so it is not cached either
+    CHECK(evaluateEdits(source, snapOnly, snapOnly.size(), &cache).cachedSteps == 0);
+    CHECK(evaluateEdits(source, ops, ops.size(), &cache).cachedSteps == 3);
+}
+
+} // namespace
+
+int main()
+{
+    testRotateMerging();
+    testReplacePrefix();
+    testHashing();
+    testCachedPrefix();
+    testSnapFoldsRotation();
+
+    if (failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("page_edits_test: all checks passed\n");
+    return 0;
+}
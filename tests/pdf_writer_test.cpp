@@ -0,0 +1,245 @@
+// Writes a bilevel, a JPEG and a passthrough page, then reads the file back
+// through its cross-reference table, and checks that JPEGs a viewer would
+// show wrongly are refused for passthrough.
+#include "pdf_writer.h"
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <zlib.h>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(cond)                                                          \
+    do {                                                                     \
+        if (!(cond)) {                                                       \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,     \
+                         __LINE__, #cond);                                   \
+            ++failures;                                                      \
+        }                                                                    \
+    } while (0)
+
+// Every xref entry is exactly 20 bytes: 10-digit offset, 5-digit generation
+constexpr size_t kXrefEntryBytes = 20;
+
+std::string readFile(const fs::path &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), {});
+}
+
+// Offset of the first segment with the given marker, or npos
+size_t findMarker(const std::vector<unsigned char> &jpeg, unsigned char marker)
+{
+    size_t pos = 2;
+    while (pos + 4 <= jpeg.size() && jpeg[pos] == 0xFF) {
+        if (jpeg[pos + 1] == marker)
+            return pos;
+        if (jpeg[pos + 1] == 0xDA)
+            break;
+        pos += 2 + ((static_cast<size_t>(jpeg[pos + 2]) << 8) | jpeg[pos + 3]);
+    }
+    return std::string::npos;
+}
+
+// Any of the frame markers a baseline/progressive encoder writes
+size_t findFrame(const std::vector<unsigned char> &jpeg)
+{
+    for (const unsigned char marker : {0xC0, 0xC1, 0xC2}) {
+        const size_t pos = findMarker(jpeg, marker);
+        if (pos != std::string::npos)
+            return pos;
+    }
+    return std::string::npos;
+}
+
+// Big-endian EXIF APP1 segment holding only an orientation tag
+std::vector<unsigned char> exifSegment(unsigned orientation)
+{
+    const std::vector<unsigned char> payload = {
+        'E', 'x', 'i', 'f', 0, 0,
+        'M', 'M', 0, 42, 0, 0, 0, 8,                  // TIFF header, IFD at 8
+        0, 1,                                         // one entry
+        0x01, 0x12, 0, 3, 0, 0, 0, 1,                 // Orientation, SHORT, 1
+        0, static_cast<unsigned char>(orientation), 0, 0,
+        0, 0, 0, 0,                                   // no next IFD
+    };
+    const size_t length = payload.size() + 2;
+    std::vector<unsigned char> segment = {0xFF, 0xE1, static_cast<unsigned char>(length >> 8),
+                                          static_cast<unsigned char>(length & 0xFF)};
+    segment.insert(segment.end(), payload.begin(), payload.end());
+    return segment;
+}
+
+// The stream of the image XObject starting at or after `from`
+std::string imageStream(const std::string &pdf, size_t from, size_t *end = nullptr)
+{
+    const size_t image = pdf.find("/Subtype /Image", from);
+    if (image == std::string::npos)
+        return {};
+    const size_t lengthKey = pdf.find("/Length ", image);
+    const size_t data = pdf.find(">>\nstream\n", image);
+    if (lengthKey == std::string::npos || data == std::string::npos)
+        return {};
+    const size_t length = std::strtoul(pdf.c_str() + lengthKey + 8, nullptr, 10);
+    const size_t begin = data + 10;
+    if (begin + length > pdf.size())
+        return {};
+    if (end)
+        *end = begin + length;
+    return pdf.substr(begin, length);
+}
+
+// 10x3 page, white where (x + y) is a multiple of 3
+cv::Mat bilevelPage()
+{
+    cv::Mat page(3, 10, CV_8UC1);
+    for (int y = 0; y < page.rows; ++y) {
+        for (int x = 0; x < page.cols; ++x)
+            page.at<unsigned char>(y, x) = (x + y) % 3 == 0 ? 255 : 0;
+    }
+    return page;
+}
+
+void testPages(const fs::path &path)
+{
+    const cv::Mat bilevel = bilevelPage();
+    cv::Mat gray(8, 16, CV_8UC1);
+    for (int y = 0; y < gray.rows; ++y) {
+        for (int x = 0; x < gray.cols; ++x)
+            gray.at<unsigned char>(y, x) = static_cast<unsigned char>(x * 16 + y);
+    }
+    std::vector<unsigned char> jpeg;
+    CHECK(cv::imencode(".jpg", cv::Mat(10, 20, CV_8UC3, cv::Scalar(40, 120, 200)), jpeg));
+
+    PdfWriter writer;
+    CHECK(writer.open(path.string()));
+    CHECK(writer.addImagePage(bilevel, 301));
+    CHECK(writer.addImagePage(gray, 300));
+    CHECK(writer.addJpegPassthroughPage(jpeg, 200));
+    CHECK(writer.pageCount() == 3);
+    CHECK(writer.close());
+
+    const std::string pdf = readFile(path);
+    CHECK(pdf.compare(0, 9, "%PDF-1.4\n") == 0);
+
+    // startxref points at the table, and each entry at "<id> 0 obj"
+    const size_t startxref = pdf.rfind("startxref\n");
+    CHECK(startxref != std::string::npos);
+    if (startxref == std::string::npos)
+        return;
+    const size_t xref = std::strtoul(pdf.c_str() + startxref + 10, nullptr, 10);
+    CHECK(pdf.compare(xref, 7, "xref\n0 ") == 0);
+    char *sizeEnd = nullptr;
+    const size_t objects = std::strtoul(pdf.c_str() + xref + 7, &sizeEnd, 10);
+    CHECK(objects == 1 + 2 + 3 * 3);  // free entry, catalog and pages, 3 per page
+    const size_t entries = static_cast<size_t>(sizeEnd - pdf.c_str()) + 1;
+    CHECK(pdf.compare(entries, kXrefEntryBytes, "0000000000 65535 f \n") == 0);
+    for (size_t id = 1; id < objects; ++id) {
+        const std::string entry = pdf.substr(entries + id * kXrefEntryBytes, kXrefEntryBytes);
+        CHECK(entry.size() == kXrefEntryBytes && entry.compare(10, 10, " 00000 n \n") == 0);
+        const size_t objectOffset = std::strtoul(entry.c_str(), nullptr, 10);
+        const std::string header = std::to_string(id) + " 0 obj\n";
+        CHECK(pdf.compare(objectOffset, header.size(), header) == 0);
+    }
+    CHECK(pdf.find("trailer\n<< /Size " + std::to_string(objects) + " /Root 1 0 R >>") != std::string::npos);
+
+    // Page sizes in points: rounded to three decimals, trailing zeros dropped
+    CHECK(pdf.find("/MediaBox [0 0 2.392 0.718]") != std::string::npos);  // 10x3 at 301 dpi
+    CHECK(pdf.find("/MediaBox [0 0 3.84 1.92]") != std::string::npos);    // 16x8 at 300 dpi
+    CHECK(pdf.find("/MediaBox [0 0 7.2 3.6]") != std::string::npos);      // 20x10 at 200 dpi
+
+    // Bilevel page: 1-bit rows padded to whole bytes, bit set = white
+    size_t next = 0;
+    const std::string flate = imageStream(pdf, 0, &next);
+    CHECK(pdf.find("/BitsPerComponent 1 /Filter /FlateDecode") != std::string::npos);
+    std::vector<unsigned char> packed(2 * bilevel.rows);
+    uLongf packedSize = static_cast<uLongf>(packed.size());
+    CHECK(uncompress(packed.data(), &packedSize, reinterpret_cast<const Bytef *>(flate.data()),
+                     static_cast<uLong>(flate.size())) == Z_OK);
+    CHECK(packedSize == packed.size());
+    std::vector<unsigned char> expected(packed.size(), 0);
+    for (int y = 0; y < bilevel.rows; ++y) {
+        for (int x = 0; x < bilevel.cols; ++x) {
+            if ((x + y) % 3 == 0)
+                expected[2 * y + x / 8] |= static_cast<unsigned char>(0x80u >> (x % 8));
+        }
+    }
+    CHECK(packed == expected);
+
+    // JPEG page: re-encoded as DCT, decodes back to the same size
+    const std::string dct = imageStream(pdf, next, &next);
+    const std::vector<unsigned char> dctBytes(dct.begin(), dct.end());
+    const cv::Mat decoded = cv::imdecode(dctBytes, cv::IMREAD_UNCHANGED);
+    CHECK(decoded.cols == 16 && decoded.rows == 8 && decoded.channels() == 1);
+
+    // Passthrough page: the file's bytes, unchanged
+    const std::string passthrough = imageStream(pdf, next);
+    CHECK(passthrough == std::string(jpeg.begin(), jpeg.end()));
+}
+
+// JPEGs that PDF viewers would show rotated, in the wrong colors or not at
+// all are refused without writing a page
+void testPassthroughRefused(const fs::path &path)
+{
+    std::vector<unsigned char> jpeg;
+    CHECK(cv::imencode(".jpg", cv::Mat(10, 20, CV_8UC3, cv::Scalar(40, 120, 200)), jpeg));
+    const size_t frame = findFrame(jpeg);
+    CHECK(frame != std::string::npos);
+    if (frame == std::string::npos)
+        return;
+
+    std::vector<unsigned char> rotated = jpeg;
+    const std::vector<unsigned char> exif = exifSegment(6);
+    rotated.insert(rotated.begin() + 2, exif.begin(), exif.end());
+
+    std::vector<unsigned char> upright = jpeg;
+    const std::vector<unsigned char> uprightExif = exifSegment(1);
+    upright.insert(upright.begin() + 2, uprightExif.begin(), uprightExif.end());
+
+    std::vector<unsigned char> cmyk = jpeg;
+    cmyk[frame + 4 + 5] = 4;  // component count in the frame header
+
+    std::vector<unsigned char> arithmetic = jpeg;
+    arithmetic[frame + 1] = 0xC9;  // SOF9: extended sequential, arithmetic
+
+    PdfWriter writer;
+    CHECK(writer.open(path.string()));
+    CHECK(!writer.addJpegPassthroughPage(rotated, 200));
+    CHECK(!writer.addJpegPassthroughPage(cmyk, 200));
+    CHECK(!writer.addJpegPassthroughPage(arithmetic, 200));
+    CHECK(writer.pageCount() == 0);
+    CHECK(writer.addJpegPassthroughPage(upright, 200));
+    CHECK(writer.pageCount() == 1);
+    CHECK(writer.close());
+}
+
+} // namespace
+
+int main()
+{
+    std::error_code ec;
+    const fs::path dir = fs::temp_directory_path() / "pixlscan_pdf_writer_test";
+    fs::remove_all(dir, ec);
+    fs::create_directories(dir);
+
+    testPages(dir / "pages.pdf");
+    testPassthroughRefused(dir / "refused.pdf");
+
+    fs::remove_all(dir, ec);
+    if (failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("pdf_writer_test: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,183 @@
+// Round-trips a session file and checks that damaged headers are rejected
+// cleanly instead of crashing or allocating for a bogus page count.
+#include "session_file.h"
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(cond)                                                          \
+    do {                                                                     \
+        if (!(cond)) {                                                       \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,     \
+                         __LINE__, #cond);                                   \
+            ++failures;                                                      \
+        }                                                                    \
+    } while (0)
+
+// Header fields patched by the tests; see the layout in session_file.cpp
+constexpr std::streamoff kVersionOffset = 8;
+constexpr std::streamoff kPageCountOffset = 16;
+constexpr std::streamoff kTableSizeOffset = 32;
+// Smallest page table record; kMinPageRecordBytes in session_file.cpp
+constexpr uint64_t kMinPageRecordBytes = 80;
+
+template <typename T>
+T readField(const fs::path &path, std::streamoff offset)
+{
+    T value{};
+    std::ifstream in(path, std::ios::binary);
+    in.seekg(offset);
+    in.read(reinterpret_cast<char *>(&value), sizeof(T));
+    return value;
+}
+
+template <typename T>
+void writeField(const fs::path &path, std::streamoff offset, T value)
+{
+    std::fstream out(path, std::ios::binary | std::ios::in | std::ios::out);
+    out.seekp(offset);
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+// Open must fail without throwing
+bool rejects(const fs::path &path)
+{
+    try {
+        return SessionFile::open(path.string()) == nullptr;
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "SessionFile::open threw: %s\n", e.what());
+        return false;
+    }
+}
+
+std::vector<SessionPage> makePages(const fs::path &source)
+{
+    SessionPage edited;
+    edited.sourcePath = source.string();
+    edited.source = fingerprintFile(edited.sourcePath);
+    edited.edits = {EditOp::snap({{0.1f, 0.2f}, {0.9f, 0.1f}, {0.8f, 0.9f}, {0.1f, 0.8f}}), EditOp::rotate(90)};
+    edited.appliedSteps = 1;
+    edited.autoSnapTried = true;
+    edited.thumbnail = cv::Mat(20, 30, CV_8UC3, cv::Scalar(1, 2, 3));
+    edited.preview = cv::Mat(40, 60, CV_8UC3, cv::Scalar(4, 5, 6));
+
+    SessionPage plain;
+    plain.sourcePath = source.string();
+    plain.source = edited.source;
+    return {edited, plain};
+}
+
+void testRoundTrip(const fs::path &session, const fs::path &source)
+{
+    CHECK(writeSession(session.string(), makePages(source)));
+    const auto file = SessionFile::open(session.string());
+    CHECK(file != nullptr);
+    if (!file)
+        return;
+    CHECK(file->pages().size() == 2);
+    if (file->pages().size() != 2)
+        return;
+    const SessionPage &page = file->pages()[0];
+    CHECK(page.edits.size() == 2);
+    CHECK(page.appliedSteps == 1);
+    CHECK(page.autoSnapTried);
+    CHECK(!file->pages()[1].autoSnapTried);
+    CHECK(page.thumbnail.size() == cv::Size(30, 20));
+    CHECK(page.preview.at<cv::Vec3b>(39, 59) == cv::Vec3b(4, 5, 6));
+    CHECK(reinterpret_cast<uintptr_t>(page.preview.data) % 64 == 0);
+    CHECK(sourceUnchanged(source.string(), page.source));
+    CHECK(file->pages()[1].thumbnail.empty());
+}
+
+// A page count larger than the page table could hold is rejected before
+// anything is allocated for it
+void testCorruptPageCount(const fs::path &session, const fs::path &source)
+{
+    for (const uint32_t count : {0xFFFFFFFFu, 0x10000000u}) {
+        CHECK(writeSession(session.string(), makePages(source)));
+        writeField<uint32_t>(session, kPageCountOffset, count);
+        CHECK(rejects(session));
+    }
+
+    // A count the table size allows, but more records than were written
+    CHECK(writeSession(session.string(), makePages(source)));
+    const uint64_t tableSize = readField<uint64_t>(session, kTableSizeOffset);
+    const uint64_t plausible = std::max<uint64_t>(tableSize / kMinPageRecordBytes, 3);
+    writeField<uint32_t>(session, kPageCountOffset, static_cast<uint32_t>(plausible));
+    CHECK(rejects(session));
+}
+
+// A table size pointing past the end of the file
+void testCorruptTableSize(const fs::path &session, const fs::path &source)
+{
+    CHECK(writeSession(session.string(), makePages(source)));
+    writeField<uint64_t>(session, kTableSizeOffset, ~uint64_t{0});
+    CHECK(rejects(session));
+}
+
+// Version 1 records end after the pixel blocks; they open without flags
+void testVersion1(const fs::path &session, const fs::path &source)
+{
+    std::vector<SessionPage> pages = makePages(source);
+    pages.resize(1);
+    CHECK(writeSession(session.string(), pages));
+    const uint64_t tableSize = readField<uint64_t>(session, kTableSizeOffset);
+    writeField<uint32_t>(session, kVersionOffset, 1);
+    writeField<uint64_t>(session, kTableSizeOffset, tableSize - sizeof(uint32_t));
+    const auto file = SessionFile::open(session.string());
+    CHECK(file != nullptr);
+    if (!file || file->pages().size() != 1)
+        return;
+    CHECK(file->pages()[0].edits.size() == 2);
+    CHECK(!file->pages()[0].autoSnapTried);
+}
+
+void testTruncated(const fs::path &session, const fs::path &source)
+{
+    CHECK(writeSession(session.string(), makePages(source)));
+    fs::resize_file(session, fs::file_size(session) - 5);
+    CHECK(rejects(session));
+}
+
+} // namespace
+
+int main()
+{
+    std::error_code ec;
+    const fs::path dir = fs::temp_directory_path() / "pixlscan_session_test";
+    fs::remove_all(dir, ec);
+    fs::create_directories(dir);
+    const fs::path source = dir / "source.bin";
+    {
+        std::ofstream out(source, std::ios::binary);
+        out << std::string(1000, 'x');
+    }
+    const fs::path session = dir / "session.pxs";
+
+    testRoundTrip(session, source);
+    testCorruptPageCount(session, source);
+    testCorruptTableSize(session, source);
+    testVersion1(session, source);
+    testTruncated(session, source);
+
+    fs::remove_all(dir, ec);
+    if (failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("session_file_test: all checks passed\n");
+    return 0;
+}